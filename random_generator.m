@@ -6,9 +6,10 @@
 
 /*
 SYNOPSIS
-#define _XOPEN_SOURCE
 #include <pthread.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <limits.h>
 #include "random_generator.m"
 */
@@ -16,8 +17,52 @@ SYNOPSIS
 /*****************************************************************
 * RANDOM NUMBER GENERATOR                                        *
 *****************************************************************/
+// Each thread draws from its own generator (splitmix64), so that threads never contend on a shared state.
+// Generators are seeded from a common seed: the thread that calls random_seed draws the first stream,
+// the other threads draw the following streams, in the order of their first draw after the seed was set.
+// Concurrent work that must be reproducible from the seed selects its streams with random_stream instead.
 static pthread_once_t random_init_once = PTHREAD_ONCE_INIT;
-static unsigned int rand_seed = 0;
+static atomic_ullong random_seed_base = 0;
+static atomic_ullong random_nb_streams = 0;
+static atomic_uint random_generation = 1;
+
+struct sRandomState
+{
+  uint64_t state;
+  unsigned int generation;
+};
+static _Thread_local struct sRandomState random_state;
+
+static uint64_t
+random_mix (uint64_t z)
+{
+  z = (z ^ (z >> 30)) * UINT64_C (0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C (0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+/// This function seeds the generators of all threads (the calling thread is reseeded immediately, the others on their next draw).
+///
+/// @param [in] seed Seed.
+static void
+random_seed (unsigned long long seed)
+{
+  atomic_store (&random_seed_base, seed);
+  atomic_store (&random_nb_streams, 1);
+  random_state.state = random_mix (seed);
+  random_state.generation = atomic_fetch_add (&random_generation, 1) + 1;
+}
+
+/// This function makes the calling thread draw from the stream 'key', whatever the thread and the order of the draws
+/// (until the next call to random_seed).
+///
+/// @param [in] key Stream, e.g. a key drawn by the seeded thread plus the index of a task.
+static void
+random_stream (uint64_t key)
+{
+  random_state.state = random_mix (key);
+  random_state.generation = atomic_load_explicit (&random_generation, memory_order_acquire);
+}
 
 /// This function initializes the generator from the clock of the computer.
 static void
@@ -27,7 +72,21 @@ random_init ()
   fprintf (stderr, _("RANDOM GENERATOR INITIALIZATION"));
   fprintf (stderr, "\n");
 #endif
-  rand_seed = (unsigned int) time (NULL) + (unsigned int) (intptr_t) (&rand_seed);      //Cast from int* to unsigned int
+  random_seed ((unsigned long long) time (NULL) + (unsigned long long) (intptr_t) (&random_seed_base));
+}
+
+/// This function draws a random 64-bit integer.
+static uint64_t
+random_next ()
+{
+  unsigned int generation = atomic_load_explicit (&random_generation, memory_order_acquire);
+  if (random_state.generation != generation)
+  {
+    uint64_t stream = atomic_fetch_add (&random_nb_streams, 1);
+    random_state.state = random_mix (atomic_load (&random_seed_base) + stream * UINT64_C (0x9e3779b97f4a7c15));
+    random_state.generation = generation;
+  }
+  return random_mix (random_state.state += UINT64_C (0x9e3779b97f4a7c15));
 }
 
 /// This function draws a random integer uniformaly between 0 and n included.
@@ -45,21 +104,19 @@ alea (int n)
   // Draw a random integer number between 0 and n included ([0, n]).
   if (n == 0)
     return 0;
-  else if (n < 0 || RAND_MAX < n || n == INT_MAX)
+  else if (n < 0)
   {
-    ASSERT (0 <= n && n <= RAND_MAX, 0);
+    ASSERT (0 <= n, 0);
     abort ();
   }
 
-  // Here, n != 0 and n != INT_MAX and n <= RAND_MAX
-  // The idea here is not to overflow integer range or random generator range
-  // (avoiding the use of RAND_MAX + 1.)
-  int blockSize = n == RAND_MAX ? 1 : (1 + (RAND_MAX - n) / (n + 1));      // blockSize = (RAND_MAX + 1)/(n + 1)
-  int upperLimit = blockSize * n + (blockSize - 1);       // upperLimit = (n + 1) * blockSize - 1
-  int draw;
-  while ((draw = rand_r (&rand_seed)) > upperLimit)
+  // Draws below 2^64 mod (n + 1) are rejected, so that the remainder is not biased.
+  uint64_t bound = (uint64_t) n + 1;
+  uint64_t threshold = -bound % bound;
+  uint64_t draw;
+  while ((draw = random_next ()) < threshold)
     /* nothing here */ ;
-  return draw / blockSize;
+  return draw % bound;
 }
 
 #endif
@@ -6,26 +6,62 @@
 SYNOPSIS
 #include <pthread.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include "rw_lock.m"
 */
 /*****************************************************************
 * MULTI-THREAD ACCESS CONTROL IMPLEMENTATION                     *
 *****************************************************************/
 /** SINGLE-WRITE MULTIPLE-READ LOCK      **/
+// The state of the lock is held in a single atomic word: the highest bit is set when a writer owns (or waits for) the lock,
+// the other bits count the readers.
+// Readers and writers enter and leave with a single atomic operation when there is no contention.
+// The mutex and the condition variable are only used by threads that have to wait (slow path).
+#define RW_AC_WRITER (1u << (sizeof (unsigned int) * CHAR_BIT - 1))
+#define RW_AC_READERS (~RW_AC_WRITER)
+
 typedef struct sSWMRLock
 {
-  pthread_mutex_t read;
-  pthread_mutex_t write;
-  pthread_cond_t reading;
-  int nb_readers;
+  atomic_uint state;
+  atomic_int nb_waiters;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
 } rw_access_control_t;
 
+// Wakes up the threads waiting in the slow path, if any.
+private int
+_rw_ac_wake (rw_access_control_t * pac)
+{
+  int status;
+  if (!atomic_load (&pac->nb_waiters))
+    return 0;
+  if ((status = pthread_mutex_lock (&pac->mutex)))
+    return status;
+  if ((status = pthread_cond_broadcast (&pac->changed)))
+  {
+    pthread_mutex_unlock (&pac->mutex);
+    return status;
+  }
+  return pthread_mutex_unlock (&pac->mutex);
+}
+
 private void
 _mutex_cancel_cleanup (void *arg)
 {
   rw_access_control_t *pac = arg;
-  pthread_mutex_unlock (&pac->write);
-  pthread_mutex_unlock (&pac->read);
+  atomic_fetch_sub (&pac->nb_waiters, 1);
+  pthread_mutex_unlock (&pac->mutex);
+}
+
+private void
+_writer_cancel_cleanup (void *arg)
+{
+  rw_access_control_t *pac = arg;
+  // Give up the lock acquired by the writer, and let the waiting readers in.
+  atomic_fetch_and (&pac->state, RW_AC_READERS);
+  pthread_cond_broadcast (&pac->changed);
+  _mutex_cancel_cleanup (pac);
 }
 
 private rw_access_control_t *
@@ -34,21 +70,20 @@ rw_ac_create ()
   rw_access_control_t *pac = malloc (sizeof (*pac));
   if (!pac)
     return 0;
-  if (pthread_mutex_init (&pac->write, 0))
-    return 0;
-  if (pthread_mutex_init (&pac->read, 0))
+  if (pthread_mutex_init (&pac->mutex, 0))
   {
-    pthread_mutex_destroy (&pac->write);
+    free (pac);
     return 0;
   }
-  if (pthread_cond_init (&pac->reading, 0))
+  if (pthread_cond_init (&pac->changed, 0))
   {
-    pthread_mutex_destroy (&pac->write);
-    pthread_mutex_destroy (&pac->read);
+    pthread_mutex_destroy (&pac->mutex);
+    free (pac);
     return 0;
   }
 
-  pac->nb_readers = 0;
+  atomic_init (&pac->state, 0);
+  atomic_init (&pac->nb_waiters, 0);
   return pac;
 }
 
@@ -56,17 +91,38 @@ private int
 rw_ac_write_begin (rw_access_control_t * pac)
 {
   int status;
-  if ((status = pthread_mutex_lock (&pac->write)))
+  unsigned int state = 0;
+
+  // Fast path: neither readers nor writer.
+  if (atomic_compare_exchange_strong (&pac->state, &state, RW_AC_WRITER))
+    return 0;
+
+  if ((status = pthread_mutex_lock (&pac->mutex)))
     return status;
-  if ((status = pthread_mutex_lock (&pac->read)))
+  atomic_fetch_add (&pac->nb_waiters, 1);
+
+  pthread_cleanup_push (_mutex_cancel_cleanup, pac);
+
+  // Wait for the other writer to leave, then take the writer bit (new readers are kept out from now on).
+  while (1)
   {
-    pthread_mutex_unlock (&pac->write);
-    return status;
+    state = atomic_load (&pac->state);
+    if (!(state & RW_AC_WRITER))
+    {
+      if (atomic_compare_exchange_strong (&pac->state, &state, state | RW_AC_WRITER))
+        break;
+    }
+    // Cancellation point
+    else if ((status = pthread_cond_wait (&pac->changed, &pac->mutex)))
+      return status;
   }
 
-  pthread_cleanup_push (_mutex_cancel_cleanup, pac);
+  pthread_cleanup_pop (0);      // _mutex_cancel_cleanup
+
+  pthread_cleanup_push (_writer_cancel_cleanup, pac);
 
-  while (pac->nb_readers)
+  // Wait for the readers to leave.
+  while (atomic_load (&pac->state) & RW_AC_READERS)
   {
 #ifdef TEST_CANCELLATION_POINT
     if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
@@ -75,13 +131,14 @@ rw_ac_write_begin (rw_access_control_t * pac)
 #endif
 
     // Cancellation point
-    if ((status = pthread_cond_wait (&pac->reading, &pac->read)))
+    if ((status = pthread_cond_wait (&pac->changed, &pac->mutex)))
       return status;
   }
 
-  pthread_cleanup_pop (0);      // _mutex_cancel_cleanup
+  pthread_cleanup_pop (0);      // _writer_cancel_cleanup
 
-  if ((status = pthread_mutex_unlock (&pac->read)))
+  atomic_fetch_sub (&pac->nb_waiters, 1);
+  if ((status = pthread_mutex_unlock (&pac->mutex)))
     return status;
 
   return 0;
@@ -90,52 +147,24 @@ rw_ac_write_begin (rw_access_control_t * pac)
 private int
 rw_ac_write_try_begin (rw_access_control_t * pac)
 {
-  int status;
-  if ((status = pthread_mutex_trylock (&pac->write)))
-    return status;
-  if ((status = pthread_mutex_lock (&pac->read)))
-  {
-    pthread_mutex_unlock (&pac->write);
-    return status;
-  }
-
-  if (pac->nb_readers)
-  {
-    if ((status = pthread_mutex_unlock (&pac->read)))
-    {
-      pthread_mutex_unlock (&pac->write);
-      return status;
-    }
-    else if ((status = pthread_mutex_unlock (&pac->write)))
-      return status;
-    else
-      return EBUSY;
-  }
-  else if ((status = pthread_mutex_unlock (&pac->read)))
-    return status;
-
-  return 0;
+  unsigned int state = 0;
+  if (atomic_compare_exchange_strong (&pac->state, &state, RW_AC_WRITER))
+    return 0;
+  return EBUSY;
 }
 
 private int
 rw_ac_write_end (rw_access_control_t * pac)
 {
-  return pthread_mutex_unlock (&pac->write);
+  if (!(atomic_fetch_and (&pac->state, RW_AC_READERS) & RW_AC_WRITER))
+    return EPERM;
+  return _rw_ac_wake (pac);
 }
 
 private int
 rw_ac_read_begin (rw_access_control_t * pac)
 {
   int status;
-  if ((status = pthread_mutex_lock (&pac->write)))
-    return status;
-  if ((status = pthread_mutex_lock (&pac->read)))
-  {
-    pthread_mutex_unlock (&pac->write);
-    return status;
-  }
-
-  pthread_cleanup_push (_mutex_cancel_cleanup, pac);
 
 #ifdef TEST_CANCELLATION_POINT
   if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
@@ -146,56 +175,62 @@ rw_ac_read_begin (rw_access_control_t * pac)
   // Cancellation point
   pthread_testcancel ();
 
-  pthread_cleanup_pop (0);      // _mutex_cancel_cleanup
+  // Fast path: no writer.
+  unsigned int state = atomic_load_explicit (&pac->state, memory_order_relaxed);
+  while (!(state & RW_AC_WRITER))
+    if (atomic_compare_exchange_weak (&pac->state, &state, state + 1))
+      return 0;
 
-  pac->nb_readers++;
+  if ((status = pthread_mutex_lock (&pac->mutex)))
+    return status;
+  atomic_fetch_add (&pac->nb_waiters, 1);
+
+  pthread_cleanup_push (_mutex_cancel_cleanup, pac);
 
-  if ((status = pthread_mutex_unlock (&pac->read)))
+  // Wait for the writer to leave.
+  while (1)
   {
-    pthread_mutex_unlock (&pac->write);
-    return status;
+    state = atomic_load (&pac->state);
+    if (!(state & RW_AC_WRITER))
+    {
+      if (atomic_compare_exchange_strong (&pac->state, &state, state + 1))
+        break;
+    }
+    // Cancellation point
+    else if ((status = pthread_cond_wait (&pac->changed, &pac->mutex)))
+      return status;
   }
-  else
-    return pthread_mutex_unlock (&pac->write);
+
+  pthread_cleanup_pop (0);      // _mutex_cancel_cleanup
+
+  atomic_fetch_sub (&pac->nb_waiters, 1);
+  return pthread_mutex_unlock (&pac->mutex);
 }
 
 private int
 rw_ac_read_try_begin (rw_access_control_t * pac)
 {
-  int status;
-  if ((status = pthread_mutex_trylock (&pac->write)))
-    return status;
-  if ((status = pthread_mutex_lock (&pac->read)))
-  {
-    pthread_mutex_unlock (&pac->write);
-    return status;
-  }
-
-  pac->nb_readers++;
-
-  if ((status = pthread_mutex_unlock (&pac->read)))
-    return status;
-  if ((status = pthread_mutex_unlock (&pac->write)))
-    return status;
-  return 0;
+  unsigned int state = atomic_load_explicit (&pac->state, memory_order_relaxed);
+  while (!(state & RW_AC_WRITER))
+    if (atomic_compare_exchange_weak (&pac->state, &state, state + 1))
+      return 0;
+  return EBUSY;
 }
 
 private int
 rw_ac_read_end (rw_access_control_t * pac)
 {
-  int status;
-  if (!pac->nb_readers)
-    return 0;
-  if ((status = pthread_mutex_lock (&pac->read)))
-    return status;
+  unsigned int state = atomic_load_explicit (&pac->state, memory_order_relaxed);
+  do
+  {
+    if (!(state & RW_AC_READERS))
+      return 0;
+  }
+  while (!atomic_compare_exchange_weak (&pac->state, &state, state - 1));
 
-  pac->nb_readers--;
-  if (!pac->nb_readers)
-    if ((status = pthread_cond_signal (&pac->reading)))
-      return status;
-
-  if ((status = pthread_mutex_unlock (&pac->read)))
-    return status;
+  // The last reader leaves while a writer is waiting.
+  if ((state & RW_AC_READERS) == 1 && (state & RW_AC_WRITER))
+    return _rw_ac_wake (pac);
 
   return 0;
 }
@@ -209,13 +244,14 @@ rw_ac_destroy (rw_access_control_t * pac)
   int status;
   if ((status = rw_ac_write_try_begin (pac)))
     return status;
-  else if ((status = rw_ac_write_end (pac)))
-    return status;
-  if ((status = pthread_cond_destroy (&pac->reading)))
-    return status;
-  if ((status = pthread_mutex_destroy (&pac->read)))
+  if (atomic_load (&pac->nb_waiters))
+  {
+    rw_ac_write_end (pac);
+    return EBUSY;
+  }
+  if ((status = pthread_cond_destroy (&pac->changed)))
     return status;
-  if ((status = pthread_mutex_destroy (&pac->write)))
+  if ((status = pthread_mutex_destroy (&pac->mutex)))
     return status;
   free (pac);
 
@@ -18,6 +18,8 @@
 */
 #define _XOPEN_SOURCE
 #define _XOPEN_SOURCE_EXTENDED
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE         // anonymous mappings, huge pages, system calls of NUMA
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,6 +28,13 @@
 #include <time.h>
 #include <pthread.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/syscall.h>
 
 #include "lib15puzzle.h"
 #include "sp_solve.h"
@@ -45,6 +54,13 @@ pthread_t *thread_cancellation_point_test = 0;
 #endif
 
 //#define TRACE 1
+// Disabled traces: arguments are still evaluated, without comma expressions (-Wunused-value).
+static inline void
+sliding_puzzle_trace_discard (const void *puzzle, ...)
+{
+  (void) puzzle;
+}
+
 #if TRACE == 2
 
 #  define PUZZLE_DEBUG(puzzle, ...) \
@@ -64,7 +80,7 @@ pthread_t *thread_cancellation_point_test = 0;
 
 #elif TRACE == 1
 
-#  define PUZZLE_DEBUG(puzzle, ...) (void)((void)(puzzle), (void)(__VA_ARGS__))
+#  define PUZZLE_DEBUG(puzzle, ...) sliding_puzzle_trace_discard ((puzzle), __VA_ARGS__)
 
 #  define PUZZLE_PRINT(puzzle, ...) \
   do {\
@@ -77,7 +93,7 @@ pthread_t *thread_cancellation_point_test = 0;
 
 #else
 
-#  define PUZZLE_DEBUG(puzzle, ...) (void)((void)(puzzle), (void)(__VA_ARGS__))
+#  define PUZZLE_DEBUG(puzzle, ...) sliding_puzzle_trace_discard ((puzzle), __VA_ARGS__)
 #  define PUZZLE_PRINT(puzzle, ...)  PUZZLE_DEBUG(puzzle, __VA_ARGS__)
 
 #endif
@@ -97,15 +113,18 @@ sliding_puzzle_solver_version ()
 /** Modules - BEGIN **/
 
 /** USING RANDOM GENERATOR MODULE **/
-#define _XOPEN_SOURCE
 #include <pthread.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <limits.h>
 #include "random_generator.m"
 
 /** USING RW_LOCK MODULE **/
 #include <pthread.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
 #include "rw_lock.m"
 
 #include <inttypes.h>
@@ -152,12 +171,27 @@ struct sHeuristicData
   int8_t *database;
 };
 
+// Databases are reference counted without locking: every puzzle using a database holds a reference to it,
+// and the database is destroyed when the last reference is dropped.
 struct sHeuristicDatabase
 {
   struct sHeuristicData *database_sol;
   int size_sol;
   int *mirror_sol, *mirror_pos;
-  int nbUsers;
+  // Pattern of each tile, and offset of each of its positions in the index of the pattern (and the same for the mirrored
+  // patterns, mirrored positions included): the index of a pattern is the sum of the offsets of its tiles.
+  // tile_offset[tile * size + position] (see sliding_puzzle_heuristic_database_tiles).
+  int *tile_pattern, *mirror_tile_pattern;
+  uint32_t *tile_offset, *mirror_tile_offset;
+  void *mapping;                // shared memory, or memory allocated following 'policy', holding the distance tables, if any
+  size_t mapping_size;
+  int policy;                   // memory policy of the distance tables (see enum eHeuristicMemoryPolicy)
+  int effective_policy;         // memory policy the system granted, after fallbacks
+  // Copies of the database per NUMA node (replicas[0] is the database itself), if any.
+  // Replicas share the description of the patterns with the database, and live as long as it.
+  struct sHeuristicDatabase **replicas;
+  int nb_replicas;
+  atomic_int nbUsers;
 };
 
 typedef struct sHeuristicDatabase *HeuristicDatabase;
@@ -165,11 +199,94 @@ typedef struct sHeuristicDatabase *HeuristicDatabase;
 struct sCycleDatabase
 {
   ACMachine (char) * cycles;
-  int nbUsers;
+  atomic_int nbUsers;
 };
 
 typedef struct sCycleDatabase *CycleDatabase;
 
+// Complete table of the distances to the target of all the states of a small puzzle, found by retrograde breadth-first search.
+// States are indexed by the rank of the permutation of the grid, and distances are stored modulo 3 on 2 bits,
+// which is enough to descend greedily to the target: a neighbour one move closer is at (distance + 2) mod 3.
+#define DISTANCE_TABLE_MAX_TILES 12
+#define DISTANCE_UNKNOWN 3
+
+struct sDistanceTable
+{
+  int width, height;
+  uint64_t nb_states;           // (width * height)!
+  uint8_t *distances;
+  atomic_int nbUsers;
+};
+
+typedef struct sDistanceTable *DistanceTable;
+
+// Perimeter around the target: all the states within 'radius' moves of the target, with their exact distance,
+// found by breadth-first search from the target and stored in an open-addressing hash table.
+// A state is packed into two 64-bit words ('bits' bits per tile), which limits perimeters to puzzles of 25 tiles.
+#define PERIMETER_MAX_TILES 25
+#define PERIMETER_EMPTY UINT64_MAX
+// The goal side of the bidirectional searches is such a perimeter, private to the search, within BIDA_MEMORY_BUDGET.
+#define BIDA_MEMORY_BUDGET ((size_t) 256 << 20)
+
+struct sPerimeterDatabase
+{
+  int radius;
+  int bits;
+  uint64_t capacity;            // power of 2
+  uint64_t count;
+  uint64_t (*keys)[2];
+  int8_t *distances;
+  atomic_int nbUsers;
+};
+
+typedef struct sPerimeterDatabase *PerimeterDatabase;
+
+// Databases published to a puzzle (RCU-like), not in use yet.
+// They replace the databases of the puzzle when the next solver starts, so that running solvers are never disturbed.
+struct sDatabaseUpdate
+{
+  _Atomic (HeuristicDatabase) heuristic_database;
+  _Atomic (CycleDatabase) cycle_database;
+};
+
+// Moves and distances of a board, which only depend on its shape and target, shared by all the puzzles alike.
+// - The moves of the blank from position i are pos_perm[upper_nb_perms[i - 1]] to pos_perm[upper_nb_perms[i]] (excluded),
+//   the new positions of the blank (upper_nb_perms[-1] is 0).
+// - dir_perm[move] is the move of the tile toward the blank, as spelled in cycle banks ('u', 'd', 'l' or 'r').
+// - inv_perm[move] is the index of the opposite move, from the new position of the blank back to i.
+// - manhattan[tile * size + pos] is the Manhattan distance of 'tile' at position 'pos' to its target position,
+//   for boards of at most BOARD_MANHATTAN_MAX_SIZE cells only (0 otherwise).
+#define BOARD_MANHATTAN_MAX_SIZE (UINT8_MAX + 1)
+
+struct sBoard
+{
+  int width, height;
+  int nb_perms;
+  int *pos_perm;
+  int *upper_nb_perms;
+  char *dir_perm;
+  int *inv_perm;
+  uint8_t *manhattan;
+  atomic_int nbUsers;
+};
+
+typedef struct sBoard *Board;
+
+// Progress of a running search, published by the solver and read lock-free by sliding_puzzle_progress_get.
+// Generated nodes are published by chunks of PROGRESS_NODES_GRANULARITY to keep the search loop cheap.
+#define PROGRESS_NODES_GRANULARITY 4096
+
+struct sSearchProgress
+{
+  atomic_int running;
+  atomic_int threshold;
+  atomic_int iteration;
+  atomic_int f_bound;
+  atomic_ullong nodes;
+  atomic_llong start;           // nanoseconds, monotonic clock
+  atomic_llong stop;            // nanoseconds, monotonic clock
+};
+
 struct sPuzzle
 {
   int width, height;
@@ -182,18 +299,23 @@ struct sPuzzle
   int *grid_sol;                // Tiles of target solution
   int *pos_sol;                 // Position of tiles of target solution
 
-  int *pos_perm;                // depends on width and height
-  int nb_perms;                 // depends on width and height
-  int *upper_nb_perms;          // depends on width and height
+  Board board;                  // depends on width, height and target
 
   CycleDatabase cycle_database;
   const ACState (char) * cycle_state;
   HeuristicDatabase heuristic_database;
+  DistanceTable distance_table;
+  PerimeterDatabase perimeter_database;
+  int d2perimeter;              // exact distance to target if the puzzle is within the perimeter, 0 otherwise
+  struct sDatabaseUpdate *update;
 
   FILE *stream;
   Puzzle_move_handler solution_shower;
 
   rw_access_control_t *accessControl;
+  struct sSearchProgress *progress;     // shared by the puzzle and all its successors during search
+  int nb_threads;               // threads used by the solvers
+  atomic_int *stop;             // if set, the search is abandoned (shared by the puzzle and all its successors)
 
   int solved;
   int solution_length;
@@ -202,10 +324,47 @@ struct sPuzzle
 
 typedef struct sPuzzle const *constPuzzle;
 
+// State of a node of the searches. Everything else (size, moves, target, databases, progress...) is read from
+// the puzzle being solved, shared by all the nodes.
+// Tiles and positions are stored on one byte per cell, two for boards of more than 256 cells.
+#define NODE_CELL(size) ((size) > UINT8_MAX + 1 ? 2 : 1)
+
+struct sNode
+{
+  void *grid;                   // Tiles at position i
+  void *pos;                    // Positions of tile i
+  int d2sol;                    // Minimal distances to solution
+  int d2patterns[2];            // Distances of the patterns and of the mirrored patterns, with a heuristic database
+  int orient;
+  int d2perimeter;
+  int solved;
+  const ACState (char) * cycle_state;
+};
+
+// Cell 'i' of an array of 'cell' bytes per cell (sizeof (int) for the grids of puzzles).
+// Cells of 0 bytes are the 4-bit nibbles of a 64-bit word (bitboards, read only).
+static inline int
+sliding_puzzle_cell_get (const void *array, int i, int cell)
+{
+  return cell == 0 ? (int) ((*(const uint64_t *) array >> (4 * i)) & 0xF) : cell == 1 ? ((const uint8_t *) array)[i] :
+    cell == 2 ? ((const uint16_t *) array)[i] : ((const int *) array)[i];
+}
+
+static inline void
+sliding_puzzle_cell_set (void *array, int i, int value, int cell)
+{
+  if (cell == 1)
+    ((uint8_t *) array)[i] = value;
+  else if (cell == 2)
+    ((uint16_t *) array)[i] = value;
+  else
+    ((int *) array)[i] = value;
+}
+
 struct BufferIDA
 {
   int move;
-  int *grid, *pos;
+  void *grid, *pos;
   uintmax_t nbGeneratedNodes;
 };
 
@@ -217,7 +376,7 @@ struct BuffersIDA
 
 typedef struct
 {
-  struct sPuzzle node;          // configuration of this node
+  struct sNode node;            // configuration of this node
   int F;
 
   int move;                     // move to get to this node
@@ -226,7 +385,7 @@ typedef struct
 struct BufferRBFS
 {
   int move;
-  int *grid[4], *pos[4];
+  void *grid[4], *pos[4];
   uintmax_t nbGeneratedNodes;
 };
 
@@ -236,57 +395,205 @@ struct BuffersRBFS
   int *pBufferLength;
 };
 
+// Search algorithms, specialized for the size of the puzzle.
+typedef int (*SearchDFRS) (Puzzle puzzle, struct sNode * node, int depth, int last, struct BufferIDA * buffer);
+typedef int (*SearchBFRS) (Puzzle puzzle, NodeRBFS * N, int depth, int V, int max_depth, struct BufferRBFS ** pBuffer,
+                           int *pBufferLength);
+
 /** Objects - END **/
 
 /** Destructors - BEGIN **/
+// Takes a reference to the tables of a board.
+static Board
+sliding_puzzle_board_ref (Board board)
+{
+  if (board)
+    atomic_fetch_add_explicit (&board->nbUsers, 1, memory_order_relaxed);
+  return board;
+}
+
+// Drops a reference to the tables of a board, and destroys them if it was the last one.
 static int
-sliding_puzzle_cycle_bank_release (Puzzle puzzle)
+sliding_puzzle_board_unref (Board board)
 {
-  if (!puzzle->cycle_database)
+  if (!board)
     return 0;
 
-  if (puzzle->cycle_database->nbUsers > 1)
-  {
-    puzzle->cycle_database->nbUsers--;
-    puzzle->cycle_database = 0;
-    puzzle->cycle_state = 0;
+  if (atomic_fetch_sub_explicit (&board->nbUsers, 1, memory_order_acq_rel) > 1)
+    return 0;
+
+  free (board->pos_perm);
+  free (board->upper_nb_perms);
+  free (board->dir_perm);
+  free (board->inv_perm);
+  free (board->manhattan);
+  free (board);
+  return 1;
+}
+
+// Takes a reference to a cycle database.
+static CycleDatabase
+sliding_puzzle_cycle_database_ref (CycleDatabase cycle_database)
+{
+  if (cycle_database)
+    atomic_fetch_add_explicit (&cycle_database->nbUsers, 1, memory_order_relaxed);
+  return cycle_database;
+}
+
+// Drops a reference to a cycle database, and destroys the database if it was the last one.
+static int
+sliding_puzzle_cycle_database_unref (CycleDatabase cycle_database)
+{
+  if (!cycle_database)
+    return 0;
+
+  if (atomic_fetch_sub_explicit (&cycle_database->nbUsers, 1, memory_order_acq_rel) > 1)
     return 0;
-  }
 
-  ACM_release (puzzle->cycle_database->cycles);
-  free (puzzle->cycle_database);
+  ACM_release (cycle_database->cycles);
+  free (cycle_database);
+  return 1;
+}
+
+static int
+sliding_puzzle_cycle_bank_release (Puzzle puzzle)
+{
+  int ret = sliding_puzzle_cycle_database_unref (puzzle->cycle_database);
   puzzle->cycle_database = 0;
   puzzle->cycle_state = 0;
-  return 1;
+  return ret;
 }
 
+// Takes a reference to a heuristic database.
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_ref (HeuristicDatabase heuristic_database)
+{
+  if (heuristic_database)
+    atomic_fetch_add_explicit (&heuristic_database->nbUsers, 1, memory_order_relaxed);
+  return heuristic_database;
+}
+
+// Drops a reference to a heuristic database, and destroys the database if it was the last one.
 static int
-sliding_puzzle_heuristic_database_release (Puzzle puzzle)
+sliding_puzzle_heuristic_database_unref (HeuristicDatabase heuristic_database)
 {
-  if (!puzzle->heuristic_database)
+  if (!heuristic_database)
     return 0;
 
-  if (puzzle->heuristic_database->nbUsers > 1)
-  {
-    puzzle->heuristic_database->nbUsers--;
-    puzzle->heuristic_database = 0;
+  if (atomic_fetch_sub_explicit (&heuristic_database->nbUsers, 1, memory_order_acq_rel) > 1)
     return 0;
-  }
 
-  for (int i = 0; i < puzzle->heuristic_database->size_sol; i++)
+  for (int i = 0; i < heuristic_database->size_sol; i++)
+  {
+    free (heuristic_database->database_sol[i].tiles);
+    if (!heuristic_database->mapping)
+      free (heuristic_database->database_sol[i].database);
+  }
+  if (heuristic_database->mapping)
+    munmap (heuristic_database->mapping, heuristic_database->mapping_size);
+  for (int i = 1; i < heuristic_database->nb_replicas; i++)
   {
-    free (puzzle->heuristic_database->database_sol[i].tiles);
-    free (puzzle->heuristic_database->database_sol[i].database);
+    munmap (heuristic_database->replicas[i]->mapping, heuristic_database->replicas[i]->mapping_size);
+    free (heuristic_database->replicas[i]->database_sol);
+    free (heuristic_database->replicas[i]);
   }
-  free (puzzle->heuristic_database->database_sol);
-  free (puzzle->heuristic_database->mirror_sol);
-  free (puzzle->heuristic_database->mirror_pos);
+  free (heuristic_database->replicas);
+  free (heuristic_database->database_sol);
+  free (heuristic_database->mirror_sol);
+  free (heuristic_database->mirror_pos);
+  free (heuristic_database->tile_pattern);
+  free (heuristic_database->tile_offset);
+  free (heuristic_database->mirror_tile_pattern);
+  free (heuristic_database->mirror_tile_offset);
+
+  free (heuristic_database);
+  return 1;
+}
 
-  free (puzzle->heuristic_database);
+static int
+sliding_puzzle_heuristic_database_release (Puzzle puzzle)
+{
+  int ret = sliding_puzzle_heuristic_database_unref (puzzle->heuristic_database);
   puzzle->heuristic_database = 0;
+  return ret;
+}
+
+// Takes a reference to a distance table.
+static DistanceTable
+sliding_puzzle_distance_table_ref (DistanceTable distance_table)
+{
+  if (distance_table)
+    atomic_fetch_add_explicit (&distance_table->nbUsers, 1, memory_order_relaxed);
+  return distance_table;
+}
+
+// Drops a reference to a distance table, and destroys the table if it was the last one.
+static int
+sliding_puzzle_distance_table_unref (DistanceTable distance_table)
+{
+  if (!distance_table)
+    return 0;
+
+  if (atomic_fetch_sub_explicit (&distance_table->nbUsers, 1, memory_order_acq_rel) > 1)
+    return 0;
+
+  free (distance_table->distances);
+  free (distance_table);
+  return 1;
+}
+
+static int
+sliding_puzzle_distance_table_release (Puzzle puzzle)
+{
+  int ret = sliding_puzzle_distance_table_unref (puzzle->distance_table);
+  puzzle->distance_table = 0;
+  return ret;
+}
+
+// Takes a reference to a perimeter database.
+static PerimeterDatabase
+sliding_puzzle_perimeter_database_ref (PerimeterDatabase perimeter_database)
+{
+  if (perimeter_database)
+    atomic_fetch_add_explicit (&perimeter_database->nbUsers, 1, memory_order_relaxed);
+  return perimeter_database;
+}
+
+// Drops a reference to a perimeter database, and destroys the database if it was the last one.
+static int
+sliding_puzzle_perimeter_database_unref (PerimeterDatabase perimeter_database)
+{
+  if (!perimeter_database)
+    return 0;
+
+  if (atomic_fetch_sub_explicit (&perimeter_database->nbUsers, 1, memory_order_acq_rel) > 1)
+    return 0;
+
+  free (perimeter_database->keys);
+  free (perimeter_database->distances);
+  free (perimeter_database);
   return 1;
 }
 
+static int
+sliding_puzzle_perimeter_database_release (Puzzle puzzle)
+{
+  int ret = sliding_puzzle_perimeter_database_unref (puzzle->perimeter_database);
+  puzzle->perimeter_database = 0;
+  return ret;
+}
+
+// Drops the databases published to the puzzle and not yet in use.
+static void
+sliding_puzzle_database_update_release (Puzzle puzzle)
+{
+  if (!puzzle->update)
+    return;
+
+  sliding_puzzle_heuristic_database_unref (atomic_exchange (&puzzle->update->heuristic_database, 0));
+  sliding_puzzle_cycle_database_unref (atomic_exchange (&puzzle->update->cycle_database, 0));
+}
+
 int
 sliding_puzzle_release (Puzzle puzzle)
 {
@@ -307,16 +614,23 @@ sliding_puzzle_release (Puzzle puzzle)
 
   free (puzzle->grid_sol);
   free (puzzle->pos_sol);
-  free (puzzle->upper_nb_perms);
-  free (puzzle->pos_perm);
+  sliding_puzzle_board_unref (puzzle->board);
   free (puzzle->grid);
   free (puzzle->pos);
   free (puzzle->solution);
+  free (puzzle->progress);
+
+  sliding_puzzle_database_update_release (puzzle);
+  free (puzzle->update);
 
   if (sliding_puzzle_heuristic_database_release (puzzle))
     PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
   if (sliding_puzzle_cycle_bank_release (puzzle))
     PUZZLE_PRINT (puzzle, _("Cycle bank released.\n"));
+  if (sliding_puzzle_distance_table_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Distance table released.\n"));
+  if (sliding_puzzle_perimeter_database_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Perimeter database released.\n"));
 
   PUZZLE_DEBUG (puzzle, _("Puzzle released.\n"));
   free (puzzle);
@@ -332,9 +646,7 @@ sliding_puzzle_release (Puzzle puzzle)
 static void
 cycle_database_cleanup (void *arg)
 {
-  CycleDatabase c = arg;
-  ACM_release (c->cycles);
-  free (c);
+  sliding_puzzle_cycle_database_unref (arg);
 }
 
 static void
@@ -356,6 +668,14 @@ sliding_puzzle_buffer_IDA_cleanup (void *arg)
   free (*pb->pBuffer);
 }
 
+static void
+sliding_puzzle_node_cleanup (void *arg)
+{
+  struct sNode *node = arg;
+  free (node->grid);
+  free (node->pos);
+}
+
 static void
 sliding_puzzle_buffer_RBFS_cleanup (void *arg)
 {
@@ -376,8 +696,7 @@ sliding_puzzle_cycle_cleanup (void *arg)
 
   free (cycling->grid_sol);
   free (cycling->pos_sol);
-  free (cycling->upper_nb_perms);
-  free (cycling->pos_perm);
+  sliding_puzzle_board_unref (cycling->board);
   free (cycling->grid);
   free (cycling->pos);
   ASSERT_FALSE (rw_ac_destroy (cycling->accessControl), _("POSIX thread finalization error"));
@@ -390,17 +709,19 @@ sliding_puzzle_cycle_cleanup (void *arg)
 static void
 sliding_puzzle_heuristic_database_cleanup (void *arg)
 {
-  HeuristicDatabase heuristic_database = arg;
-  for (int i = 0; i < heuristic_database->size_sol; i++)
-  {
-    free (heuristic_database->database_sol[i].tiles);
-    free (heuristic_database->database_sol[i].database);
-  }
-  free (heuristic_database->database_sol);
-  free (heuristic_database->mirror_sol);
-  free (heuristic_database->mirror_pos);
+  sliding_puzzle_heuristic_database_unref (arg);
+}
 
-  free (heuristic_database);
+static void
+sliding_puzzle_distance_table_cleanup (void *arg)
+{
+  sliding_puzzle_distance_table_unref (arg);
+}
+
+static void
+sliding_puzzle_perimeter_database_cleanup (void *arg)
+{
+  sliding_puzzle_perimeter_database_unref (arg);
 }
 
 static void sliding_puzzle_read_end (Puzzle puzzle);
@@ -471,104 +792,418 @@ sliding_puzzle_write_end (Puzzle puzzle)
 
 /** Multi-threading access control toolbox - END **/
 
-/** Sliding puzzle toolbox - BEGIN **/
+/** Progress toolbox - BEGIN **/
+// Progress is written by the solving thread only and read by any thread without locking.
+static long long
+sliding_puzzle_clock_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-/** Cycles - BEGIN **/
-// Searching for cycles makes use of DFRS
-static int sliding_puzzle_depth_first_recursive_search (Puzzle puzzle, int depth, int last, struct BufferIDA *buffer);
+static void
+sliding_puzzle_progress_start (Puzzle puzzle)
+{
+  struct sSearchProgress *p = puzzle->progress;
+  if (!p)
+    return;
 
-static Puzzle
-sliding_puzzle_for_cycling_init (int width, int height)
+  atomic_store_explicit (&p->threshold, 0, memory_order_relaxed);
+  atomic_store_explicit (&p->iteration, 0, memory_order_relaxed);
+  atomic_store_explicit (&p->f_bound, 0, memory_order_relaxed);
+  atomic_store_explicit (&p->nodes, 0, memory_order_relaxed);
+  atomic_store_explicit (&p->stop, 0, memory_order_relaxed);
+  atomic_store_explicit (&p->start, sliding_puzzle_clock_ns (), memory_order_relaxed);
+  atomic_store_explicit (&p->running, 1, memory_order_release);
+}
+
+// Publishes the state of the search at the beginning of an iteration (IDA*) or of a deeper level (RBFS).
+static void
+sliding_puzzle_progress_iteration (Puzzle puzzle, int threshold, int f_bound, const uintmax_t *nodes)
 {
-  if (width <= 0 || height <= 0)
-    return 0;
+  struct sSearchProgress *p = puzzle->progress;
+  if (!p)
+    return;
 
-  Puzzle cycling = malloc (sizeof (*cycling));
-  cycling->width = 2 * width - 1;
-  cycling->height = 2 * height - 1;
+  atomic_store_explicit (&p->threshold, threshold, memory_order_relaxed);
+  atomic_store_explicit (&p->f_bound, f_bound, memory_order_relaxed);
+  if (nodes)
+    atomic_store_explicit (&p->nodes, *nodes, memory_order_relaxed);
+  atomic_fetch_add_explicit (&p->iteration, 1, memory_order_release);
+}
 
-  cycling->grid = malloc (cycling->width * cycling->height * sizeof (*cycling->grid));
-  cycling->pos = malloc (cycling->width * cycling->height * sizeof (*cycling->pos));
-  cycling->grid_sol = malloc (cycling->width * cycling->height * sizeof (*cycling->grid_sol));
-  cycling->pos_sol = malloc (cycling->width * cycling->height * sizeof (*cycling->pos_sol));
+// Publishes the final state of the search.
+static void
+sliding_puzzle_progress_result (Puzzle puzzle, int f_bound, uintmax_t nodes)
+{
+  struct sSearchProgress *p = puzzle->progress;
+  if (!p)
+    return;
 
-  cycling->pos[0] = (cycling->width * cycling->height - 1) / 2;
-  for (int i = 0; i < cycling->width * cycling->height; i++)
-  {
-    if (i < cycling->pos[0])
-      cycling->grid_sol[i] = cycling->grid[i] = i + 1;
-    else if (i > cycling->pos[0])
-      cycling->grid_sol[i] = cycling->grid[i] = i;
-    else
-      cycling->grid_sol[i] = cycling->grid[i] = 0;
-  }
-  cycling->grid[cycling->pos[0]] = cycling->grid[cycling->pos[0] + 1];
-  cycling->pos[0]++;
-  cycling->grid[cycling->pos[0]] = 0;
+  atomic_store_explicit (&p->f_bound, f_bound, memory_order_relaxed);
+  atomic_store_explicit (&p->nodes, nodes, memory_order_relaxed);
+}
 
-  for (int i = 0; i < cycling->width * cycling->height; i++)
-    cycling->pos[cycling->grid[i]] = i;
+static void
+sliding_puzzle_progress_stop (void *arg)
+{
+  Puzzle puzzle = arg;
+  struct sSearchProgress *p = puzzle->progress;
+  if (!p)
+    return;
 
-  for (int i = 0; i < cycling->width * cycling->height; i++)
-    cycling->pos_sol[cycling->grid_sol[i]] = i;
+  atomic_store_explicit (&p->stop, sliding_puzzle_clock_ns (), memory_order_relaxed);
+  atomic_store_explicit (&p->running, 0, memory_order_release);
+}
 
-  cycling->d2sol = 1;
-  cycling->solved = 0;
-  cycling->orient = 1;          // for cycle search
-  cycling->cycle_database = 0;
-  cycling->cycle_state = 0;
-  cycling->heuristic_database = 0;
-  cycling->stream = 0;
-  cycling->solution_shower = 0;
-  cycling->accessControl = 0;
+/** Progress toolbox - END **/
+
+/** Registry of databases - BEGIN **/
+// Process-wide cache of the databases built by sliding_puzzle_*_database_attach, keyed by their construction parameters:
+// - (width, height, target, pattern size, memory policy) for heuristic databases (see HEURISTIC_REGISTRY_SIZE),
+// - (width, height, group of each tile) for heuristic databases of user-defined patterns,
+// - (width, height, cycle length) for cycle banks,
+// - (width, height) for distance tables,
+// - (width, height, target, radius, hash table capacity) for perimeter databases (see PERIMETER_REGISTRY_SIZE),
+// - (width, height, target) for the tables of boards.
+// The registry holds a reference to every database it caches, until sliding_puzzle_database_registry_flush is called.
+// Concurrent requests for the same database wait for a single build.
+enum eDatabaseKind
+{
+  HEURISTIC_DATABASE,
+  CYCLE_DATABASE,
+  DISTANCE_TABLE,
+  PERIMETER_DATABASE,
+  BOARD_TABLES
+};
 
-  cycling->pos_perm =
-    malloc ((4 * cycling->width * cycling->height -
-             2 * (cycling->width + cycling->height)) * sizeof (*cycling->pos_perm));
-  cycling->nb_perms = 0;
-  cycling->upper_nb_perms = malloc (cycling->width * cycling->height * sizeof (*cycling->upper_nb_perms));
-  for (int i = 0; i < cycling->width * cycling->height; i++)
+struct sRegistryEntry
+{
+  enum eDatabaseKind kind;
+  int width, height, size;
+  int *goal;                    // target grid, for heuristic databases and boards only
+  void *database;               // 0 while the database is being built
+  struct sRegistryEntry *next;
+};
+
+static struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t built;
+  struct sRegistryEntry *entries;
+} registry = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
+
+static void
+sliding_puzzle_registry_unlock (void *arg)
+{
+  (void) arg;
+  pthread_mutex_unlock (&registry.mutex);
+}
+
+// Needs the registry lock.
+static struct sRegistryEntry **
+sliding_puzzle_registry_find (enum eDatabaseKind kind, int width, int height, int size, const int *goal)
+{
+  struct sRegistryEntry **pe;
+  for (pe = &registry.entries; *pe; pe = &(*pe)->next)
+    if ((*pe)->kind == kind && (*pe)->width == width && (*pe)->height == height && (*pe)->size == size
+        && (!goal || !memcmp ((*pe)->goal, goal, width * height * sizeof (*goal))))
+      break;
+  return pe;
+}
+
+// Thread cancellable
+// Returns a new reference to the registered database if any.
+// Otherwise, registers the database as being built and returns 0: the caller is then in charge of the build,
+// and must call either sliding_puzzle_registry_store or sliding_puzzle_registry_abort with '*pentry'.
+static void *
+sliding_puzzle_registry_lookup (enum eDatabaseKind kind, int width, int height, int size, const int *goal,
+                                struct sRegistryEntry **pentry)
+{
+  void *volatile database = 0;  // set after the setjmp of pthread_cleanup_push
+  *pentry = 0;
+
+  ASSERT_FALSE (pthread_mutex_lock (&registry.mutex), _("POSIX thread error"));
+  pthread_cleanup_push (sliding_puzzle_registry_unlock, 0);
+
+  struct sRegistryEntry *entry;
+  // Wait for a concurrent build of the same database, if any.
+  while ((entry = *sliding_puzzle_registry_find (kind, width, height, size, goal)) && !entry->database)
+    // Cancellation point
+    ASSERT_FALSE (pthread_cond_wait (&registry.built, &registry.mutex), _("POSIX thread error"));
+
+  if (entry && kind == HEURISTIC_DATABASE)
+    database = sliding_puzzle_heuristic_database_ref (entry->database);
+  else if (entry && kind == DISTANCE_TABLE)
+    database = sliding_puzzle_distance_table_ref (entry->database);
+  else if (entry && kind == PERIMETER_DATABASE)
+    database = sliding_puzzle_perimeter_database_ref (entry->database);
+  else if (entry && kind == BOARD_TABLES)
+    database = sliding_puzzle_board_ref (entry->database);
+  else if (entry)
+    database = sliding_puzzle_cycle_database_ref (entry->database);
+  else
   {
-    if (i - cycling->width >= 0)
-    {
-      cycling->pos_perm[cycling->nb_perms] = i - cycling->width;
-      cycling->nb_perms++;
-    }
-    if (i + cycling->width < cycling->width * cycling->height)
-    {
-      cycling->pos_perm[cycling->nb_perms] = i + cycling->width;
-      cycling->nb_perms++;
-    }
-    if (i - 1 >= 0 && (i - 1) / cycling->width == i / cycling->width)
-    {
-      cycling->pos_perm[cycling->nb_perms] = i - 1;
-      cycling->nb_perms++;
-    }
-    if (i + 1 < cycling->width * cycling->height && (i + 1) / cycling->width == i / cycling->width)
+    CHECK_ALLOC (entry = malloc (sizeof (*entry)));
+    entry->kind = kind;
+    entry->width = width;
+    entry->height = height;
+    entry->size = size;
+    entry->goal = 0;
+    if (goal)
     {
-      cycling->pos_perm[cycling->nb_perms] = i + 1;
-      cycling->nb_perms++;
+      CHECK_ALLOC (entry->goal = malloc (width * height * sizeof (*entry->goal)));
+      memcpy (entry->goal, goal, width * height * sizeof (*entry->goal));
     }
-    cycling->upper_nb_perms[i] = cycling->nb_perms;
+    entry->database = 0;
+    entry->next = registry.entries;
+    registry.entries = entry;
+    *pentry = entry;
   }
 
-  ASSERT (cycling->accessControl = rw_ac_create (), _("POSIX thread initialization error"));
-
-  PUZZLE_DEBUG (cycling, _("Puzzle created.\n"));
+  pthread_cleanup_pop (1);      // sliding_puzzle_registry_unlock
 
-  return cycling;
+  return database;
 }
 
 static void
-sliding_puzzle_for_cycling_register_cycle (ACMachine (char) * sm, size_t length, char *moves)
+sliding_puzzle_registry_entry_remove (struct sRegistryEntry *entry)
 {
-  if (!sm || !length || !moves)
-    return;
+  for (struct sRegistryEntry ** pe = &registry.entries; *pe; pe = &(*pe)->next)
+    if (*pe == entry)
+    {
+      *pe = entry->next;
+      break;
+    }
+  free (entry->goal);
+  free (entry);
+}
 
-  char *key = malloc (length * sizeof (*key));
-  char *revkey = malloc (length * sizeof (*revkey));
+// Registers a built database, with a new reference to it.
+static void
+sliding_puzzle_registry_store (struct sRegistryEntry *entry, void *database)
+{
+  ASSERT_FALSE (pthread_mutex_lock (&registry.mutex), _("POSIX thread error"));
+  if (!database)
+    sliding_puzzle_registry_entry_remove (entry);
+  else if (entry->kind == HEURISTIC_DATABASE)
+    entry->database = sliding_puzzle_heuristic_database_ref (database);
+  else if (entry->kind == DISTANCE_TABLE)
+    entry->database = sliding_puzzle_distance_table_ref (database);
+  else if (entry->kind == PERIMETER_DATABASE)
+    entry->database = sliding_puzzle_perimeter_database_ref (database);
+  else if (entry->kind == BOARD_TABLES)
+    entry->database = sliding_puzzle_board_ref (database);
+  else
+    entry->database = sliding_puzzle_cycle_database_ref (database);
+  ASSERT_FALSE (pthread_cond_broadcast (&registry.built), _("POSIX thread error"));
+  ASSERT_FALSE (pthread_mutex_unlock (&registry.mutex), _("POSIX thread error"));
+}
 
-  // 16 combinations from one path
+// Cleaner for a canceled build: waiting requests will try to build the database themselves.
+static void
+sliding_puzzle_registry_abort (void *arg)
+{
+  sliding_puzzle_registry_store (arg, 0);
+}
+
+// Thread safe
+void
+sliding_puzzle_database_registry_flush (void)
+{
+  ASSERT_FALSE (pthread_mutex_lock (&registry.mutex), _("POSIX thread error"));
+  struct sRegistryEntry **pe = &registry.entries;
+  while (*pe)
+  {
+    struct sRegistryEntry *entry = *pe;
+    if (!entry->database)       // being built
+    {
+      pe = &entry->next;
+      continue;
+    }
+    if (entry->kind == HEURISTIC_DATABASE)
+      sliding_puzzle_heuristic_database_unref (entry->database);
+    else if (entry->kind == DISTANCE_TABLE)
+      sliding_puzzle_distance_table_unref (entry->database);
+    else if (entry->kind == PERIMETER_DATABASE)
+      sliding_puzzle_perimeter_database_unref (entry->database);
+    else if (entry->kind == BOARD_TABLES)
+      sliding_puzzle_board_unref (entry->database);
+    else
+      sliding_puzzle_cycle_database_unref (entry->database);
+    *pe = entry->next;
+    free (entry->goal);
+    free (entry);
+  }
+  ASSERT_FALSE (pthread_mutex_unlock (&registry.mutex), _("POSIX thread error"));
+}
+
+/** Registry of databases - END **/
+
+/** Sliding puzzle toolbox - BEGIN **/
+
+/** Boards - BEGIN **/
+static Board
+sliding_puzzle_board_create (int width, int height, const int *grid_sol)
+{
+  int size = width * height;
+  Board board;
+  CHECK_ALLOC (board = malloc (sizeof (*board)));
+  board->width = width;
+  board->height = height;
+
+  // Loop on authorized moves.
+  // Initialize valid permutations : valid moves, considering grid borders
+  // upper_nb_perms[i] is is the number of possible moves for tiles for which position is between 0 and position i.
+  // pos_perm, with index from 0 to nb_perms[i] (excluded) is the list of those authorized moves.
+  int max_perms = 4 * size - 2 * (width + height);
+  CHECK_ALLOC (board->pos_perm = malloc (max_perms * sizeof (*board->pos_perm)));
+  CHECK_ALLOC (board->dir_perm = malloc (max_perms * sizeof (*board->dir_perm)));
+  CHECK_ALLOC (board->inv_perm = malloc (max_perms * sizeof (*board->inv_perm)));
+  CHECK_ALLOC (board->upper_nb_perms = malloc (size * sizeof (*board->upper_nb_perms)));
+  board->nb_perms = 0;
+  for (int i = 0; i < size; i++)
+  {
+    if (i - width >= 0)         // not the upper border
+    {
+      board->dir_perm[board->nb_perms] = 'd';
+      board->pos_perm[board->nb_perms++] = i - width;
+    }
+    if (i + width < size)       // not the lower border
+    {
+      board->dir_perm[board->nb_perms] = 'u';
+      board->pos_perm[board->nb_perms++] = i + width;
+    }
+    if (i - 1 >= 0 && (i - 1) / width == i / width)     // not the leftmost border
+    {
+      board->dir_perm[board->nb_perms] = 'r';
+      board->pos_perm[board->nb_perms++] = i - 1;
+    }
+    if (i + 1 < size && (i + 1) / width == i / width)   // not the rightmost border
+    {
+      board->dir_perm[board->nb_perms] = 'l';
+      board->pos_perm[board->nb_perms++] = i + 1;
+    }
+    board->upper_nb_perms[i] = board->nb_perms;
+  }
+
+  for (int i = 0; i < size; i++)
+    for (int move = i > 0 ? board->upper_nb_perms[i - 1] : 0; move < board->upper_nb_perms[i]; move++)
+    {
+      int j = board->pos_perm[move];
+      for (int back = j > 0 ? board->upper_nb_perms[j - 1] : 0; back < board->upper_nb_perms[j]; back++)
+        if (board->pos_perm[back] == i)
+          board->inv_perm[move] = back;
+    }
+
+  board->manhattan = 0;
+  if (size <= BOARD_MANHATTAN_MAX_SIZE)
+  {
+    CHECK_ALLOC (board->manhattan = malloc (size * size * sizeof (*board->manhattan)));
+    for (int target = 0; target < size; target++)
+      for (int pos = 0; pos < size; pos++)
+        board->manhattan[grid_sol[target] * size + pos] =
+          abs (pos / width - target / width) + abs (pos % width - target % width);
+  }
+
+  atomic_init (&board->nbUsers, 1);
+  return board;
+}
+
+// Returns a new reference to the tables of boards of this shape and target, built once for all.
+static Board
+sliding_puzzle_board_get (int width, int height, const int *grid_sol)
+{
+  struct sRegistryEntry *entry;
+  Board board = sliding_puzzle_registry_lookup (BOARD_TABLES, width, height, 0, grid_sol, &entry);
+  if (!board)
+  {
+    board = sliding_puzzle_board_create (width, height, grid_sol);
+    sliding_puzzle_registry_store (entry, board);
+  }
+  return board;
+}
+
+/** Boards - END **/
+
+/** Cycles - BEGIN **/
+// Searching for cycles makes use of DFRS
+static int sliding_puzzle_depth_first_recursive_search (Puzzle puzzle, struct sNode *node, int depth, int last,
+                                                        struct BufferIDA *buffer);
+static void sliding_puzzle_node_init (constPuzzle puzzle, struct sNode *node);
+
+static Puzzle
+sliding_puzzle_for_cycling_init (int width, int height)
+{
+  if (width <= 0 || height <= 0 || (2 * width - 1) * (2 * height - 1) > UINT16_MAX + 1)
+    return 0;
+
+  Puzzle cycling = malloc (sizeof (*cycling));
+  cycling->width = 2 * width - 1;
+  cycling->height = 2 * height - 1;
+
+  cycling->grid = malloc (cycling->width * cycling->height * sizeof (*cycling->grid));
+  cycling->pos = malloc (cycling->width * cycling->height * sizeof (*cycling->pos));
+  cycling->grid_sol = malloc (cycling->width * cycling->height * sizeof (*cycling->grid_sol));
+  cycling->pos_sol = malloc (cycling->width * cycling->height * sizeof (*cycling->pos_sol));
+
+  cycling->pos[0] = (cycling->width * cycling->height - 1) / 2;
+  for (int i = 0; i < cycling->width * cycling->height; i++)
+  {
+    if (i < cycling->pos[0])
+      cycling->grid_sol[i] = cycling->grid[i] = i + 1;
+    else if (i > cycling->pos[0])
+      cycling->grid_sol[i] = cycling->grid[i] = i;
+    else
+      cycling->grid_sol[i] = cycling->grid[i] = 0;
+  }
+  cycling->grid[cycling->pos[0]] = cycling->grid[cycling->pos[0] + 1];
+  cycling->pos[0]++;
+  cycling->grid[cycling->pos[0]] = 0;
+
+  for (int i = 0; i < cycling->width * cycling->height; i++)
+    cycling->pos[cycling->grid[i]] = i;
+
+  for (int i = 0; i < cycling->width * cycling->height; i++)
+    cycling->pos_sol[cycling->grid_sol[i]] = i;
+
+  cycling->d2sol = 1;
+  cycling->solved = 0;
+  cycling->orient = 1;          // for cycle search
+  cycling->cycle_database = 0;
+  cycling->cycle_state = 0;
+  cycling->heuristic_database = 0;
+  cycling->distance_table = 0;
+  cycling->perimeter_database = 0;
+  cycling->d2perimeter = 0;
+  cycling->update = 0;
+  cycling->stream = 0;
+  cycling->solution_shower = 0;
+  cycling->accessControl = 0;
+  cycling->progress = 0;
+  cycling->nb_threads = 1;
+  cycling->stop = 0;
+
+  cycling->board = sliding_puzzle_board_get (cycling->width, cycling->height, cycling->grid_sol);
+
+  ASSERT (cycling->accessControl = rw_ac_create (), _("POSIX thread initialization error"));
+
+  PUZZLE_DEBUG (cycling, _("Puzzle created.\n"));
+
+  return cycling;
+}
+
+static void
+sliding_puzzle_for_cycling_register_cycle (ACMachine (char) * sm, size_t length, char *moves)
+{
+  if (!sm || !length || !moves)
+    return;
+
+  char *key = malloc (length * sizeof (*key));
+  char *revkey = malloc (length * sizeof (*revkey));
+
+  // 16 combinations from one path
   // x-mirror (x 2)
   // y-mirror (x 2)
   // pi/2 rotation (x 2)
@@ -807,6 +1442,10 @@ sliding_puzzle_for_cycling_search (Puzzle cycling, int depth_max)
   b.pBufferLength = &prev_depth;
   pthread_cleanup_push (sliding_puzzle_buffer_IDA_cleanup, &b);
 
+  struct sNode root = { 0 };
+  pthread_cleanup_push (sliding_puzzle_node_cleanup, &root);
+  sliding_puzzle_node_init (cycling, &root);
+
 #if DEBUG
   printf (_("Cycle search depth: "));
 #endif
@@ -827,10 +1466,11 @@ sliding_puzzle_for_cycling_search (Puzzle cycling, int depth_max)
 
       buffer = realloc (buffer, next_depth * sizeof (*buffer));
 
+      int cell = NODE_CELL (cycling->width * cycling->height);
       for (int i = prev_depth; i < next_depth; i++)
       {
-        buffer[i].grid = malloc (cycling->height * cycling->width * sizeof (*buffer[i].grid));
-        buffer[i].pos = malloc (cycling->height * cycling->width * sizeof (*buffer[i].pos));
+        buffer[i].grid = malloc (cycling->height * cycling->width * cell);
+        buffer[i].pos = malloc (cycling->height * cycling->width * cell);
       }
 
       if (cycling->cycle_database)
@@ -841,7 +1481,10 @@ sliding_puzzle_for_cycling_search (Puzzle cycling, int depth_max)
       else
         cycling->cycle_state = 0;
       prev_depth = next_depth;
-      next_depth = sliding_puzzle_depth_first_recursive_search (cycling, next_depth - 1, 0, buffer + 1) + 1;
+      root.cycle_state = cycling->cycle_state;
+      root.solved = cycling->solved;
+      next_depth = sliding_puzzle_depth_first_recursive_search (cycling, &root, next_depth - 1, -1, buffer + 1) + 1;
+      cycling->solved = root.solved;
 
       if (cycling->solved == 0)
         /* nothing */ ;
@@ -885,6 +1528,7 @@ sliding_puzzle_for_cycling_search (Puzzle cycling, int depth_max)
   printf ("\n");
 #endif
 
+  pthread_cleanup_pop (1);      // sliding_puzzle_node_cleanup
   pthread_cleanup_pop (1);      // sliding_puzzle_solve_IDA_cleanup
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
 
@@ -903,11 +1547,12 @@ sliding_puzzle_cycle_bank_create (int width, int height, int max_length)
   Puzzle cycling = sliding_puzzle_for_cycling_init (width, height);
   if (!cycling)
     return 0;
+  CycleDatabase cb = 0;
   pthread_cleanup_push (sliding_puzzle_cycle_cleanup, cycling);
 
-  CycleDatabase cb = calloc (1, sizeof (*cb));
+  cb = calloc (1, sizeof (*cb));
   cb->cycles = ACM_create (char);
-  cb->nbUsers = 1;
+  atomic_init (&cb->nbUsers, 1);
   pthread_cleanup_push (cycle_database_cleanup, cb);
 
 #ifdef TEST_CANCELLATION_POINT
@@ -923,7 +1568,7 @@ sliding_puzzle_cycle_bank_create (int width, int height, int max_length)
   pthread_cleanup_pop (0);      // sm_cleanup
   pthread_cleanup_pop (1);      // cycle_cleanup
 
-  return cycling->cycle_database;
+  return cb;
 }
 
 /** Cycles - END **/
@@ -1043,9 +1688,9 @@ sliding_puzzle_distances_breadth_first_search (int8_t * database, int width, int
   return delta;
 }
 
-// Create and initialize a database
+// Create and initialize a database, in 'database' if not null, or in allocated memory otherwise.
 static int8_t *
-sliding_puzzle_heuristic_database_create (int width, int height, int size, int *start_pos)
+sliding_puzzle_heuristic_database_create (int width, int height, int size, int *start_pos, int8_t * database)
 {
   // Space of 'size' dimensions, for all possible positions for 'size' tiles.
   int *positions = malloc (size * sizeof (*positions));
@@ -1061,8 +1706,8 @@ sliding_puzzle_heuristic_database_create (int width, int height, int size, int *
   }
 
   // Database of distances from initial positions 'target_pos'
-  int8_t *database;
-  CHECK_ALLOC (database = malloc (space_size * sizeof (*database)));
+  if (!database)
+    CHECK_ALLOC (database = malloc (space_size * sizeof (*database)));
 
   // Initialize the database:
   // Loop on all possible positions of 'size' tiles reachable from every possible moves.
@@ -1109,78 +1754,124 @@ sliding_puzzle_heuristic_database_create (int width, int height, int size, int *
 
 /** Distance of tiles to solution - END **/
 
-// Computes the distance to solutions of puzzle adding distance of blocks (patterns) of tiles
-// to solution rather than the Manhattan distance.
-inline static void
-sliding_puzzle_compute_heuristic_distances_to_solutions (Puzzle puzzle)
+// Index of positions 'pos' in the distance table of pattern 'i', or of its mirror.
+static inline __attribute__ ((always_inline)) uint32_t
+sliding_puzzle_heuristic_index_kernel (HeuristicDatabase hdb, int i, int mirror, const void *pos, const int size,
+                                       const int cell)
 {
-  HeuristicDatabase hdb = puzzle->heuristic_database;
-  int size = puzzle->width * puzzle->height;
+  const struct sHeuristicData *db = &hdb->database_sol[i];
+  uint32_t index = 0;
+  for (int j = 0; j < db->nb_tiles; j++)
+    if (mirror)
+    {
+      int tile = hdb->mirror_sol[db->tiles[j]];
+      index += hdb->mirror_tile_offset[tile * size + sliding_puzzle_cell_get (pos, tile, cell)];
+    }
+    else
+      index += hdb->tile_offset[db->tiles[j] * size + sliding_puzzle_cell_get (pos, db->tiles[j], cell)];
+  return index;
+}
 
+// Computes the distance to solutions of positions 'pos' adding distance of blocks (patterns) of tiles
+// to solution rather than the Manhattan distance.
+// The distances of the patterns and of the mirrored patterns are returned in 'd2patterns' (see struct sNode).
+static int
+sliding_puzzle_heuristic_distances (HeuristicDatabase hdb, const void *pos, int size, int cell, int d2patterns[2])
+{
   // Distances to final solutions (Heuristic database patterns)
-  // Distance to solution
-  puzzle->d2sol = 0;
+  d2patterns[0] = d2patterns[1] = 0;
   for (int i = 0; i < hdb->size_sol; i++)
+    d2patterns[0] += hdb->database_sol[i].database[sliding_puzzle_heuristic_index_kernel (hdb, i, 0, pos, size, cell)];
+  if (hdb->mirror_sol)
+    for (int i = 0; i < hdb->size_sol; i++)
+      d2patterns[1] += hdb->database_sol[i].database[sliding_puzzle_heuristic_index_kernel (hdb, i, 1, pos, size, cell)];
+
+  // Distance to solution
+  return d2patterns[1] > d2patterns[0] ? d2patterns[1] : d2patterns[0];
+}
+
+// Computes the distances to solution of all the children of the node at positions 'pos' at once,
+// child 'c' moving tile 'tiles[c]' from position 'from[c]' to the empty position 'to'.
+// 'node_d2patterns' are the distances of the patterns of the node (see struct sNode), and the distances of the patterns
+// of the children are returned in 'd2patterns'.
+// A move only changes the index of the pattern of the moved tile (and of its mirror), by the difference of the offsets
+// of the tile at its two positions. Those indices are derived from the indices of the node, and the lookups of all
+// the children into the distance tables are issued back to back: their cache misses overlap, instead of stalling
+// the search child after child. The entries of the node were looked up when it was generated, and are likely in cache.
+static inline __attribute__ ((always_inline)) void
+sliding_puzzle_heuristic_children_kernel (HeuristicDatabase hdb, const void *pos, const int size, const int cell,
+                                          const int *node_d2patterns, int nb_children, const int *tiles,
+                                          const int *from, int to, int (*d2patterns)[2], int *d2sol)
+{
+  uint32_t index[4], mirror_index[4];
+
+  for (int c = 0; c < nb_children; c++)
   {
-    uintmax_t index = 0;
-    struct sHeuristicData db = hdb->database_sol[i];
-    for (int j = 0; j < db.nb_tiles; j++)
+    int p = hdb->tile_pattern[tiles[c]];
+    uint32_t node_index = sliding_puzzle_heuristic_index_kernel (hdb, p, 0, pos, size, cell);
+    d2patterns[c][0] = node_d2patterns[0] - hdb->database_sol[p].database[node_index];
+    index[c] = node_index + hdb->tile_offset[tiles[c] * size + to] - hdb->tile_offset[tiles[c] * size + from[c]];
+    d2patterns[c][1] = 0;
+    if (hdb->mirror_sol)
     {
-      index *= size;
-      index += puzzle->pos[db.tiles[j]];
+      p = hdb->mirror_tile_pattern[tiles[c]];
+      node_index = sliding_puzzle_heuristic_index_kernel (hdb, p, 1, pos, size, cell);
+      d2patterns[c][1] = node_d2patterns[1] - hdb->database_sol[p].database[node_index];
+      mirror_index[c] =
+        node_index + hdb->mirror_tile_offset[tiles[c] * size + to] - hdb->mirror_tile_offset[tiles[c] * size + from[c]];
     }
-    puzzle->d2sol += db.database[index];
   }
+
+  // Lookups of the children, back to back.
+  for (int c = 0; c < nb_children; c++)
+    d2sol[c] = d2patterns[c][0] += hdb->database_sol[hdb->tile_pattern[tiles[c]]].database[index[c]];
   if (hdb->mirror_sol)
-  {
-    int d2sol = 0;
-    for (int i = 0; i < hdb->size_sol; i++)
+    for (int c = 0; c < nb_children; c++)
     {
-      uintmax_t index = 0;
-      struct sHeuristicData db = hdb->database_sol[i];
-      for (int j = 0; j < db.nb_tiles; j++)
-      {
-        index *= size;
-        index += hdb->mirror_pos[puzzle->pos[hdb->mirror_sol[db.tiles[j]]]];
-      }
-      d2sol += db.database[index];
+      d2patterns[c][1] += hdb->database_sol[hdb->mirror_tile_pattern[tiles[c]]].database[mirror_index[c]];
+      if (d2patterns[c][1] > d2sol[c])
+        d2sol[c] = d2patterns[c][1];
     }
-    if (d2sol > puzzle->d2sol)
-      puzzle->d2sol = d2sol;
-  }
 }
 
-// Computes the distance to solution using the Manhattan distance.
+// Computes the distance to solution of positions 'pos' ('cell' bytes per cell),
+// using the heuristic database if any, the Manhattan distance otherwise.
+// The distances of the patterns are returned in 'd2patterns' if not null (see struct sNode).
 static int
-sliding_puzzle_initialize_distances_to_solutions (Puzzle puzzle)
+sliding_puzzle_distance_to_solutions (constPuzzle puzzle, const void *pos, int cell, int d2patterns[2])
 {
-  puzzle->d2sol = 0;
+  int size = puzzle->width * puzzle->height;
+  int unused[2];
   if (puzzle->heuristic_database)
-    sliding_puzzle_compute_heuristic_distances_to_solutions (puzzle);
-  else
+    return sliding_puzzle_heuristic_distances (puzzle->heuristic_database, pos, size, cell,
+                                               d2patterns ? d2patterns : unused);
+
+  // Manhattan distance to solution = sum of differences of rows and differences of columns.
+  // The distance of a tile to its target position (when the puzzle is ordered) is
+  // the number of rows between initial and final position plus
+  // the number of columns between initial and final position
+  // The distance of a puzzle grid to its solution is the sum of the distance of each tile to its final position.
+  int d2sol = 0;
+  if (puzzle->board->manhattan)
   {
-    // Manhattan distance to solution = sum of differences of rows and differences of columns.
-    // The distance of a tile to its taarget position (when the puzzle is ordered) is
-    // the number of rows between initial and final position plus
-    // the number of columns between initial and final position
-    // The distance of a puzzle grid to its solution is the sum of the distance of each tile to its final position.
-    for (int i = 0; i < puzzle->width * puzzle->height; i++)
-      if (puzzle->grid_sol[i] != 0)
-        for (int j = 0; j < puzzle->width * puzzle->height; j++)
-          if (puzzle->grid[j] == puzzle->grid_sol[i])
-          {
-            int delta_line = j / puzzle->width - i / puzzle->width;     // number of rows between initial and final position
-            if (delta_line < 0)
-              delta_line *= -1;
-
-            int delta_col = j % puzzle->width - i % puzzle->width;      // number of columns between initial and final position
-            if (delta_col < 0)
-              delta_col *= -1;
-
-            puzzle->d2sol += delta_line + delta_col;
-            break;
-          }
+    for (int tile = 1; tile < size; tile++)
+      d2sol += puzzle->board->manhattan[tile * size + sliding_puzzle_cell_get (pos, tile, cell)];
+    return d2sol;
   }
+  for (int tile = 1; tile < size; tile++)
+  {
+    int i = puzzle->pos_sol[tile];
+    int j = sliding_puzzle_cell_get (pos, tile, cell);
+    d2sol += abs (j / puzzle->width - i / puzzle->width) + abs (j % puzzle->width - i % puzzle->width);
+  }
+  return d2sol;
+}
+
+// Computes the distance to solution of the puzzle.
+static int
+sliding_puzzle_initialize_distances_to_solutions (Puzzle puzzle)
+{
+  puzzle->d2sol = sliding_puzzle_distance_to_solutions (puzzle, puzzle->pos, sizeof (*puzzle->pos), 0);
 
   PUZZLE_PRINT (puzzle, _("Distance to target: %i\n"), puzzle->d2sol);
 
@@ -1189,212 +1880,336 @@ sliding_puzzle_initialize_distances_to_solutions (Puzzle puzzle)
   return puzzle->d2sol;
 }
 
-/** Optimized solution searches algorithms - BEGIN **/
+/** Perimeter search - BEGIN **/
+static void
+sliding_puzzle_perimeter_pack (const uint8_t * grid, int size, int bits, uint64_t key[2])
+{
+  key[0] = key[1] = 0;
+  for (int i = 0, shift = 0; i < size; i++, shift += bits)
+    if (shift + bits <= 64)
+      key[0] |= (uint64_t) grid[i] << shift;
+    else if (shift >= 64)
+      key[1] |= (uint64_t) grid[i] << (shift - 64);
+    else
+    {
+      key[0] |= (uint64_t) grid[i] << shift;
+      key[1] |= (uint64_t) grid[i] >> (64 - shift);
+    }
+}
 
-/** DFRS **/
-static int
-sliding_puzzle_depth_first_recursive_search (Puzzle puzzle, int depth, int last, struct BufferIDA *buffer)
+static void
+sliding_puzzle_perimeter_unpack (const uint64_t key[2], int size, int bits, uint8_t * grid)
 {
-  // Solved ?
-  if (puzzle->d2sol == 0)
-  {
-    puzzle->solved = 1;
-    return 0;
-  }
+  uint64_t mask = (UINT64_C (1) << bits) - 1;
+  for (int i = 0, shift = 0; i < size; i++, shift += bits)
+    if (shift + bits <= 64)
+      grid[i] = (key[0] >> shift) & mask;
+    else if (shift >= 64)
+      grid[i] = (key[1] >> (shift - 64)) & mask;
+    else
+      grid[i] = ((key[0] >> shift) | (key[1] << (64 - shift))) & mask;
+}
 
-  // puzzle->pos[0] is the position of tile 0, that is the empty position.
-  int first_move = 0;
-  if (puzzle->pos[0] > 0)
-    first_move = puzzle->upper_nb_perms[puzzle->pos[0] - 1];
-  int last_move = puzzle->upper_nb_perms[puzzle->pos[0]];
+// Returns the slot of 'key' in the hash table, or the empty slot where it would be inserted.
+static uint64_t
+sliding_puzzle_perimeter_slot (const PerimeterDatabase pdb, const uint64_t key[2])
+{
+  uint64_t h = key[0] * UINT64_C (0x9e3779b97f4a7c15) ^ key[1] * UINT64_C (0xc2b2ae3d27d4eb4f);
+  uint64_t slot = (h ^ (h >> 29)) & (pdb->capacity - 1);
+  while (pdb->keys[slot][0] != PERIMETER_EMPTY && (pdb->keys[slot][0] != key[0] || pdb->keys[slot][1] != key[1]))
+    slot = (slot + 1) & (pdb->capacity - 1);
+  return slot;
+}
 
-  int next_depth = INT_MAX;
-  puzzle->solved = 0;
+// Exact distance of 'grid' to target if within the perimeter, -1 otherwise.
+static int
+sliding_puzzle_perimeter_distance (const PerimeterDatabase pdb, const uint8_t * grid, int size)
+{
+  uint64_t key[2];
+  sliding_puzzle_perimeter_pack (grid, size, pdb->bits, key);
+  uint64_t slot = sliding_puzzle_perimeter_slot (pdb, key);
+  return pdb->keys[slot][0] == PERIMETER_EMPTY ? -1 : pdb->distances[slot];
+}
 
-  // Loop on authorized moves.
-  // Try every authorized move for tile 0 (empty position).
-  // upper_nb_perms[i] is is the number of possible moves for tiles for which position is between 0 and position i.
-  // pos_perm, with index from 0 to nb_perms[i] (excluded) is the list of those authorized moves.
-  for (int move = first_move; move < last_move; move++)
+// Sharpens the heuristic distance of 'node' with the perimeter: exact inside, at least 'radius + 1' outside.
+// Perimeters are limited to puzzles of less than 256 tiles: nodes hold one byte per cell.
+static int
+sliding_puzzle_perimeter_sharpen (constPuzzle puzzle, struct sNode *node)
+{
+  // The heuristic distance is a lower bound: beyond the radius, the puzzle is outside the perimeter (no need to look up).
+  if (node->d2sol > puzzle->perimeter_database->radius)
   {
-    int initpos = puzzle->pos_perm[move];       // initial tile position = blank final position
-    int finalpos = puzzle->pos[0];      // blank initial position = final tile position
-
-    buffer->move = initpos - finalpos;  // blank tile move
-
-    int tile = puzzle->grid[initpos];   // Tile to move
+    node->d2perimeter = 0;
+    return node->d2sol;
+  }
 
-    int li = initpos / puzzle->width;   // line of initial tile position
-    int ci = initpos % puzzle->width;   // column ...
+  int d = sliding_puzzle_perimeter_distance (puzzle->perimeter_database, node->grid, puzzle->width * puzzle->height);
+  if (d >= 0)
+    return node->d2perimeter = d;
+
+  node->d2perimeter = 0;
+  // The distance to target has the parity of the Manhattan distance of the blank to its target position (0):
+  // keeping that parity, IDA* thresholds still increase by steps of 2.
+  int bound = puzzle->perimeter_database->radius + 1;
+  int blank = ((const uint8_t *) node->pos)[0];
+  if ((bound + blank / puzzle->width + blank % puzzle->width) % 2)
+    bound++;
+  return node->d2sol > bound ? node->d2sol : bound;
+}
 
-    int orient = 0;
-    const ACState (char) * s = puzzle->cycle_state;
-    if (s)                      // If a cycle bank is defined
+// Completes the path from 'grid' (blank at 'blank', at exact distance 'd' within the perimeter) to the target,
+// following decreasing exact distances. The moves are stored in 'buffer', as DFRS does. 'grid' is modified.
+static void
+sliding_puzzle_perimeter_path (const PerimeterDatabase pdb, const struct sBoard *board, uint8_t * grid, int size,
+                               int blank, int d, struct BufferIDA *buffer)
+{
+  for (; d > 0; d--, buffer++)
+  {
+    int found = 0;
+    int last_move = board->upper_nb_perms[blank];
+    for (int move = blank > 0 ? board->upper_nb_perms[blank - 1] : 0; !found && move < last_move; move++)
     {
-      if ((orient = puzzle->orient))    // assignation here, not comparison.
-        // True only for cycling puzzles, not standard puzzles.
+      int pos = board->pos_perm[move];
+      grid[blank] = grid[pos];
+      grid[pos] = 0;
+      if (sliding_puzzle_perimeter_distance (pdb, grid, size) == d - 1)
       {
-        if (initpos - finalpos == puzzle->width)
-          continue;
-        orient = 0;
+        buffer->move = pos - blank;
+        blank = pos;
+        found = 1;
       }
-
-      // Check if the last moves would be a cycle (non efficient moves).
-      // Update state machine with blank tile move
-      ZoneExtension *z = 0;
-      if (ACM_match (s,
-                     buffer->move == puzzle->width ? 'u' :
-                     buffer->move == -puzzle->width ? 'd' : buffer->move == 1 ? 'l' : 'r'))
+      else
       {
-        void *v;
-        ACM_get_match (s, 0, 0, &v);
-        z = v;
+        grid[pos] = grid[blank];
+        grid[blank] = 0;
       }
-
-      // If the last moves describe a cycle not hitting edges of the puzzle,
-      // then the last move is useless and not tried further.
-      if (z && (z->lmin + li >= 0) && (z->lmax + li < puzzle->height) && (z->cmin + ci >= 0)
-          && (z->cmax + ci < puzzle->width))
-        continue;
     }
-    // If the last moves is the opposite of the previous one,
-    // then the last move is useless and not tried further.
-    else if (buffer->move == -last)
-      continue;
-
-    buffer->nbGeneratedNodes++;
+    ASSERT (found, _("Inconsistent perimeter database"));
+  }
+}
 
-    // Copy constructor
-    struct sPuzzle successor = *puzzle;
-    successor.orient = orient;
-    successor.grid = buffer->grid;
-    memcpy (buffer->grid, puzzle->grid, successor.width * successor.height * sizeof (*buffer->grid));
-    successor.pos = buffer->pos;
-    memcpy (buffer->pos, puzzle->pos, successor.width * successor.height * sizeof (*buffer->pos));
-    successor.cycle_state = s;
-    successor.accessControl = 0;
+// Completes the path from a node within the perimeter to the target.
+static void
+sliding_puzzle_perimeter_descend (constPuzzle puzzle, const struct sNode *node, struct BufferIDA *buffer)
+{
+  int size = puzzle->width * puzzle->height;
+  uint8_t *grid = buffer->grid; // not in use by the search any more
+  memcpy (grid, node->grid, size);
+  sliding_puzzle_perimeter_path (puzzle->perimeter_database, puzzle->board, grid, size, ((const uint8_t *) node->pos)[0],
+                                 node->d2perimeter, buffer);
+}
 
-    // Move blank tile
-    successor.grid[initpos] = 0;
-    successor.grid[finalpos] = tile;
-    successor.pos[0] = initpos;
-    successor.pos[tile] = finalpos;
+// Heuristic of the goal side of bidirectional searches, toward the start (the puzzle whose tiles are at positions
+// 'toward'). The distance tables of the heuristic database, built toward the target, are looked up with the tiles
+// renamed so that the start becomes the target: a tile takes the name of the tile whose target position is its start
+// position. The tables only count the moves of the tiles of their pattern, wherever the empty spot is, so the lookups
+// stay admissible and consistent. If the empty spot of the start is not at its target position, the tile of the start
+// at that position has no name: it takes the name left over, and the tiles of the pattern of that name are counted by
+// their Manhattan distance to the start instead. Without heuristic database, the heuristic is the Manhattan distance.
+struct sPerimeterToward
+{
+  HeuristicDatabase hdb;
+  int size, width;
+  const int *toward;
+  uint8_t name[PERIMETER_MAX_TILES];    // name of each tile in the tables
+  int manhattan;                // pattern counted by Manhattan distance, -1 if none
+};
 
-    if (successor.heuristic_database)
-      sliding_puzzle_compute_heuristic_distances_to_solutions (&successor);
-    else
+static void
+sliding_puzzle_perimeter_toward_init (constPuzzle puzzle, const int *toward, struct sPerimeterToward *t)
+{
+  t->hdb = puzzle->heuristic_database;
+  t->size = puzzle->width * puzzle->height;
+  t->width = puzzle->width;
+  t->toward = toward;
+  t->manhattan = -1;
+  t->name[0] = 0;
+  for (int tile = 1; tile < t->size; tile++)
+    if (!(t->name[tile] = puzzle->grid_sol[toward[tile]]))
     {
-      // Recompute Manhattan distance
-      int lf = finalpos / puzzle->width;
-      int cf = finalpos % puzzle->width;
-
-      int delta_line, delta_col;
-      int vs1 = successor.pos_sol[tile];
-      int ls1 = vs1 / successor.width;
-      int cs1 = vs1 % successor.width;
-
-      delta_line = li > ls1 ? li - ls1 : ls1 - li;
-      delta_col = ci > cs1 ? ci - cs1 : cs1 - ci;
-      successor.d2sol -= delta_line + delta_col;
-      delta_line = lf > ls1 ? lf - ls1 : ls1 - lf;
-      delta_col = cf > cs1 ? cf - cs1 : cs1 - cf;
-      successor.d2sol += delta_line + delta_col;
+      t->name[tile] = puzzle->grid_sol[toward[0]];
+      if (t->hdb)
+        t->manhattan = t->hdb->tile_pattern[t->name[tile]];
     }
+}
 
-    // If the minimal distance to solution is lower than the maximum length of searched solutions (depth) then
-    // make an extra move, calling sliding_puzzle_depth_first_recursive_search one step further.
-    int b = successor.d2sol;
-    if (b < depth)
-      // recursive call, returns the minimal distance of successor to solution.
-      b = sliding_puzzle_depth_first_recursive_search (&successor, depth - 1, buffer->move, buffer + 1);
-    // else don't try further because we have reached the depth limit.
+static int
+sliding_puzzle_perimeter_toward (const struct sPerimeterToward *t, const uint8_t * grid)
+{
+  int d = 0;
+  if (t->hdb)
+  {
+    uint8_t pos[PERIMETER_MAX_TILES];
+    for (int p = 0; p < t->size; p++)
+      pos[t->name[grid[p]]] = p;
+    for (int i = 0; i < t->hdb->size_sol; i++)
+      if (i != t->manhattan)
+        d += t->hdb->database_sol[i].database[sliding_puzzle_heuristic_index_kernel (t->hdb, i, 0, pos, t->size, 1)];
+  }
 
-    // The minimal distance of puzzle to solution is the minimal distance of successor to solution plus one.
-    if (b >= 0 && b < INT_MAX)
-      b++;
+  for (int p = 0; p < t->size; p++)
+    if (grid[p] && (!t->hdb || t->hdb->tile_pattern[t->name[grid[p]]] == t->manhattan))
+      d += abs (p / t->width - t->toward[grid[p]] / t->width) + abs (p % t->width - t->toward[grid[p]] % t->width);
+  return d;
+}
 
-    if (successor.solved < 0)
+/** Bidirectional search **/
+// Front-to-end bidirectional IDA*. For a threshold T, the goal side holds the states within T / 2 moves of the target
+// (fewer if the memory budget is exceeded), pruned by their distance to the start (see struct sPerimeterToward):
+// a state 's' at 'g_b' moves of the target is kept only if g_b + h_start(s) <= T. The start side is IDA* down to the depth T - radius only:
+// a node 'n' at that depth is on a solution of T moves if and only if it is in the goal side, at g_b <= T - g_f
+// (all the states of such a solution within the radius pass the pruning, since h_start(n) <= g_f).
+struct sBidirectionalSearch
+{
+  constPuzzle puzzle;           // heuristic of the start side, to the target
+  PerimeterDatabase goal;       // goal side of the current threshold
+  int threshold;
+  int next;                     // smallest f-value beyond the threshold
+  uint8_t grid[PERIMETER_MAX_TILES];
+  uint8_t pos[PERIMETER_MAX_TILES];
+  struct BufferIDA *path;       // moves from the start, 'threshold' at most
+  uintmax_t nodes;
+  int length;                   // length of the solution, -1 while none, -2 if abandoned
+};
+
+// Depth-first search of the start side from the node at 'g' moves of the start, the blank at 'blank'.
+// 'parent' is the position of the blank in the parent node (-1 at the start). Returns 1 if the goal side is met.
+static int
+sliding_puzzle_bidirectional_search (struct sBidirectionalSearch *s, int g, int blank, int parent)
+{
+  constPuzzle puzzle = s->puzzle;
+  const struct sBoard *board = puzzle->board;
+  int size = puzzle->width * puzzle->height;
+
+  if (s->threshold - g <= s->goal->radius)
+  {
+    int d = sliding_puzzle_perimeter_distance (s->goal, s->grid, size);
+    if (d < 0 || g + d > s->threshold)
     {
-      puzzle->solved = successor.solved;
-      return INT_MAX;
+      // Outside the goal side, the distance to target is at least the next threshold (of the same parity).
+      int f = d < 0 ? s->threshold + 2 : g + d;
+      if (f < s->next)
+        s->next = f;
+      return 0;
     }
-    else if (successor.solved > 0)      // If solved
+    sliding_puzzle_perimeter_path (s->goal, board, s->grid, size, blank, d, s->path + g);
+    s->length = g + d;
+    return 1;
+  }
+
+  int last_move = board->upper_nb_perms[blank];
+  for (int move = blank > 0 ? board->upper_nb_perms[blank - 1] : 0; move < last_move; move++)
+  {
+    int pos = board->pos_perm[move];
+    if (pos == parent)
+      continue;
+
+    if (!(++s->nodes % PROGRESS_NODES_GRANULARITY))
     {
-      puzzle->solved = successor.solved;
-      return b;
+      if (puzzle->progress)
+        atomic_fetch_add_explicit (&puzzle->progress->nodes, PROGRESS_NODES_GRANULARITY, memory_order_relaxed);
+      // Abandoned search
+      if (puzzle->stop && atomic_load_explicit (puzzle->stop, memory_order_relaxed))
+      {
+        s->length = -2;
+        return 1;
+      }
     }
 
-    // In case finding a solution for successor would require more than INT_MAX moves (most unlikely)
-    // give up for this try and try other another move.
-    if (b < 0)
-      continue;
+    int tile = s->grid[pos];
+    s->grid[blank] = tile;
+    s->grid[pos] = 0;
+    s->pos[tile] = blank;
+    s->pos[0] = pos;
+    s->path[g].move = pos - blank;
 
-    if (b < next_depth)
-      next_depth = b;
-    // Not solved yet. Continue the loop for the next authorized move.
+    int f = g + 1 + sliding_puzzle_distance_to_solutions (puzzle, s->pos, sizeof (*s->pos), 0);
+    if (f > s->threshold)
+    {
+      if (f < s->next)
+        s->next = f;
+    }
+    else if (sliding_puzzle_bidirectional_search (s, g + 1, pos, blank))
+      return 1;
+
+    s->grid[pos] = tile;
+    s->grid[blank] = 0;
+    s->pos[tile] = pos;
+    s->pos[0] = blank;
   }
 
-  if (next_depth < INT_MAX)
-    return next_depth;          // Returns the smallest minimal distance to solution for all possible moves of tile
-  else
-    return -1;                  // In case finding a solution for puzzle would require more than INT_MAX moves (most unlikely)
+  return 0;
 }
 
-/** BFRS **/
-static int
-sliding_puzzle_best_first_recursive_search (NodeRBFS * N, int depth, int V, int max_depth, struct BufferRBFS **pBuffer,
-                                            int *pBufferLength)
+/** Perimeter search - END **/
+
+/** Optimized solution searches algorithms - BEGIN **/
+
+// Root node of a search: a compact copy of the grid of the puzzle, and its state.
+static void
+sliding_puzzle_node_init (constPuzzle puzzle, struct sNode *node)
 {
-  Puzzle node = &N->node;
-  // Solved ?
-  int h_node = node->d2sol;
-  if (h_node == 0)
+  int size = puzzle->width * puzzle->height;
+  int cell = NODE_CELL (size);
+  CHECK_ALLOC (node->grid = malloc (size * cell));
+  CHECK_ALLOC (node->pos = malloc (size * cell));
+  for (int i = 0; i < size; i++)
   {
-    node->solved = 1;
-    return depth;
+    sliding_puzzle_cell_set (node->grid, i, puzzle->grid[i], cell);
+    sliding_puzzle_cell_set (node->pos, i, puzzle->pos[i], cell);
   }
+  node->d2sol = puzzle->d2sol;
+  if (puzzle->heuristic_database)
+    sliding_puzzle_heuristic_distances (puzzle->heuristic_database, node->pos, size, cell, node->d2patterns);
+  node->orient = puzzle->orient;
+  node->d2perimeter = puzzle->d2perimeter;
+  node->solved = puzzle->solved;
+  node->cycle_state = puzzle->cycle_state;
+}
 
-  // Minimal distance (depth + h_node) is larger than INT_MAX : abort (most unlikely)
-  if (h_node > INT_MAX - depth)
+/** DFRS **/
+// Search kernel: 'width' and 'height' are compile-time constants in the specializations below,
+// which turns divisions by the width into multiplications and copies of the grid into fixed-size moves.
+// The recursive call goes through 'recurse', the specialization itself once inlined.
+// 'last' is the index of the move back to the parent node (see struct sBoard), -1 at the root of the search.
+static inline __attribute__ ((always_inline)) int
+sliding_puzzle_depth_first_recursive_search_kernel (Puzzle puzzle, struct sNode *node, int depth, int last,
+                                                    struct BufferIDA *buffer, const int width, const int height,
+                                                    SearchDFRS recurse)
+{
+  const int size = width * height;
+  const int cell = NODE_CELL (size);
+  const struct sBoard *board = puzzle->board;
+
+  // Solved ?
+  if (node->d2sol == 0)
   {
-    node->solved = -1;
-    return INT_MAX;
+    node->solved = 1;
+    return 0;
   }
 
-  // If the minimal distance to solution (depth + h_node) is higher than the searched solution length
-  // return the minimal distance to solution.
-  if (h_node > max_depth - depth)
-    return depth + h_node;
-
-  if (depth >= *pBufferLength)
+  // Within the perimeter (and within reach, otherwise the puzzle would not have been searched): the end of the path is known.
+  if (puzzle->perimeter_database && node->d2perimeter)
   {
-    *pBuffer = realloc (*pBuffer, (depth + 1) * sizeof (**pBuffer));
-    for (int i = *pBufferLength; i < depth + 1; i++)
-      for (int c = 0; c < 4; c++)
-      {
-        (*pBuffer)[i].grid[c] = malloc (node->height * node->width * sizeof (*(*pBuffer)[i].grid[c]));  // needs cancel cleanup
-        (*pBuffer)[i].pos[c] = malloc (node->height * node->width * sizeof (*(*pBuffer)[i].pos[c]));    // needs cancel cleanup
-        (*pBuffer)[i].nbGeneratedNodes = 0;
-      }
-    *pBufferLength = depth + 1;
-    PUZZLE_PRINT (node, "%i.", depth + 1);
-
-#ifdef TEST_CANCELLATION_POINT
-    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-      pthread_cancel (*thread_cancellation_point_test);
-#endif
-    // Cancellation point
-    pthread_testcancel ();
+    sliding_puzzle_perimeter_descend (puzzle, node, buffer);
+    node->solved = 1;
+    return node->d2perimeter;
   }
 
+  // pos[0] is the position of tile 0, that is the empty position.
+  int blank = sliding_puzzle_cell_get (node->pos, 0, cell);
   int first_move = 0;
-  if (node->pos[0] > 0)
-    first_move = node->upper_nb_perms[node->pos[0] - 1];
-  int last_move = node->upper_nb_perms[node->pos[0]];
+  if (blank > 0)
+    first_move = board->upper_nb_perms[blank - 1];
+  int last_move = board->upper_nb_perms[blank];
 
-  NodeRBFS children[4];
-  int nbChildren = 0;
+  int next_depth = INT_MAX;
+  node->solved = 0;
+
+  // Children of the node: moves not pruned, and the tiles they move.
+  int moves[4], tiles[4], from[4], orients[4], d2sol[4], d2patterns[4][2];
+  const ACState (char) * states[4];
+  int nb_children = 0;
 
   // Loop on authorized moves.
   // Try every authorized move for tile 0 (empty position).
@@ -1402,24 +2217,20 @@ sliding_puzzle_best_first_recursive_search (NodeRBFS * N, int depth, int V, int
   // pos_perm, with index from 0 to nb_perms[i] (excluded) is the list of those authorized moves.
   for (int move = first_move; move < last_move; move++)
   {
-    int initpos = node->pos_perm[move]; // blank final position
-    int tile = node->grid[initpos];
-
-    int finalpos = node->pos[0];        // blank initial position
-    int m = initpos - finalpos; // blank tile move
+    int initpos = board->pos_perm[move];       // initial tile position = blank final position
+    int finalpos = blank;       // blank initial position = final tile position
 
-    int li = initpos / node->width;
-    int ci = initpos % node->width;
+    int li = initpos / width;   // line of initial tile position
+    int ci = initpos % width;   // column ...
 
     int orient = 0;
-
     const ACState (char) * s = node->cycle_state;
     if (s)                      // If a cycle bank is defined
     {
       if ((orient = node->orient))      // assignation here, not comparison.
         // True only for cycling puzzles, not standard puzzles.
       {
-        if (initpos - finalpos == node->width)
+        if (initpos - finalpos == width)
           continue;
         orient = 0;
       }
@@ -1427,7 +2238,7 @@ sliding_puzzle_best_first_recursive_search (NodeRBFS * N, int depth, int V, int
       // Check if the last moves would be a cycle (non efficient moves).
       // Update state machine with blank tile move
       ZoneExtension *z = 0;
-      if (ACM_match (s, m == node->width ? 'u' : m == -node->width ? 'd' : m == 1 ? 'l' : 'r'))
+      if (ACM_match (s, board->dir_perm[move]))
       {
         void *v;
         ACM_get_match (s, 0, 0, &v);
@@ -1436,439 +2247,2956 @@ sliding_puzzle_best_first_recursive_search (NodeRBFS * N, int depth, int V, int
 
       // If the last moves describe a cycle not hitting edges of the puzzle,
       // then the last move is useless and not tried further.
-      if (z && (z->lmin + li >= 0) && (z->lmax + li < node->height) && (z->cmin + ci >= 0)
-          && (z->cmax + ci < node->width))
+      if (z && (z->lmin + li >= 0) && (z->lmax + li < height) && (z->cmin + ci >= 0)
+          && (z->cmax + ci < width))
         continue;
     }
     // If the last moves is the opposite of the previous one,
     // then the last move is useless and not tried further.
-    else if (m == -N->move)
+    else if (move == last)
       continue;
 
-    nbChildren++;
-    children[nbChildren - 1].node = *node;
-    children[nbChildren - 1].move = m;
+    moves[nb_children] = move;
+    tiles[nb_children] = sliding_puzzle_cell_get (node->grid, initpos, cell);   // Tile to move
+    from[nb_children] = initpos;
+    orients[nb_children] = orient;
+    states[nb_children] = s;
+    nb_children++;
+  }
 
-    (*pBuffer)[depth].nbGeneratedNodes++;
+  // All the children are evaluated together, before the search goes deeper.
+  if (puzzle->heuristic_database)
+    sliding_puzzle_heuristic_children_kernel (puzzle->heuristic_database, node->pos, size, cell, node->d2patterns,
+                                              nb_children, tiles, from, blank, d2patterns, d2sol);
+
+  for (int c = 0; c < nb_children; c++)
+  {
+    int move = moves[c];
+    int initpos = from[c];      // initial tile position = blank final position
+    int finalpos = blank;       // blank initial position = final tile position
+    int tile = tiles[c];        // Tile to move
+
+    buffer->move = initpos - finalpos;  // blank tile move
+
+    buffer->nbGeneratedNodes++;
+    if (!(buffer->nbGeneratedNodes % PROGRESS_NODES_GRANULARITY))
+    {
+      if (puzzle->progress)
+        atomic_fetch_add_explicit (&puzzle->progress->nodes, PROGRESS_NODES_GRANULARITY, memory_order_relaxed);
+      // Abandoned search
+      if (puzzle->stop && atomic_load_explicit (puzzle->stop, memory_order_relaxed))
+      {
+        node->solved = -1;
+        return INT_MAX;
+      }
+    }
 
     // Copy constructor
-    Puzzle successor = &children[nbChildren - 1].node;
-    successor->orient = orient;
-    successor->grid = (*pBuffer)[depth].grid[nbChildren - 1];
-    memcpy (successor->grid, node->grid, successor->width * successor->height * sizeof (*successor->grid));
-    successor->pos = (*pBuffer)[depth].pos[nbChildren - 1];
-    memcpy (successor->pos, node->pos, successor->width * successor->height * sizeof (*successor->pos));
-    successor->cycle_state = s;
+    struct sNode successor = *node;
+    successor.orient = orients[c];
+    successor.grid = buffer->grid;
+    memcpy (buffer->grid, node->grid, size * cell);
+    successor.pos = buffer->pos;
+    memcpy (buffer->pos, node->pos, size * cell);
+    successor.cycle_state = states[c];
 
     // Move blank tile
-    successor->grid[initpos] = 0;
-    successor->grid[finalpos] = tile;
-    successor->pos[0] = initpos;
-    successor->pos[tile] = finalpos;
-    successor->accessControl = 0;
-
-    if (successor->heuristic_database)
-      sliding_puzzle_compute_heuristic_distances_to_solutions (successor);
+    sliding_puzzle_cell_set (successor.grid, initpos, 0, cell);
+    sliding_puzzle_cell_set (successor.grid, finalpos, tile, cell);
+    sliding_puzzle_cell_set (successor.pos, 0, initpos, cell);
+    sliding_puzzle_cell_set (successor.pos, tile, finalpos, cell);
+
+    if (puzzle->heuristic_database)
+    {
+      successor.d2sol = d2sol[c];
+      successor.d2patterns[0] = d2patterns[c][0];
+      successor.d2patterns[1] = d2patterns[c][1];
+    }
+    else if (size <= BOARD_MANHATTAN_MAX_SIZE)
+      // Update Manhattan distance: the tile moves from initpos to finalpos.
+      successor.d2sol += board->manhattan[tile * size + finalpos] - board->manhattan[tile * size + initpos];
     else
     {
       // Recompute Manhattan distance
-      int lf = finalpos / node->width;
-      int cf = finalpos % node->width;
+      int li = initpos / width; // line of initial tile position
+      int ci = initpos % width; // column ...
+      int lf = finalpos / width;
+      int cf = finalpos % width;
 
       int delta_line, delta_col;
-      int vs1 = successor->pos_sol[tile];
-      int ls1 = vs1 / successor->width;
-      int cs1 = vs1 % successor->width;
+      int vs1 = puzzle->pos_sol[tile];
+      int ls1 = vs1 / width;
+      int cs1 = vs1 % width;
 
       delta_line = li > ls1 ? li - ls1 : ls1 - li;
       delta_col = ci > cs1 ? ci - cs1 : cs1 - ci;
-      successor->d2sol -= delta_line + delta_col;
+      successor.d2sol -= delta_line + delta_col;
       delta_line = lf > ls1 ? lf - ls1 : ls1 - lf;
       delta_col = cf > cs1 ? cf - cs1 : cs1 - cf;
-      successor->d2sol += delta_line + delta_col;
+      successor.d2sol += delta_line + delta_col;
     }
 
-    // Minimal distance of initial puzzle to solution after the extra move
-    children[nbChildren - 1].F = depth + 1 + successor->d2sol;
-
-    // Minimal distance of initial puzzle to solution before the extra move
-    int f = depth + h_node;
-
-    // If both minimal distance (before and after move) are lower than V, then
-    // the minimal is kept identical to the previous depth of iteration.
-    if (children[nbChildren - 1].F < V && f < V)
-      children[nbChildren - 1].F = V;
-  }
+    // If the minimal distance to solution is lower than the maximum length of searched solutions (depth) then
+    // make an extra move, calling the search one step further.
+    int b = puzzle->perimeter_database ? sliding_puzzle_perimeter_sharpen (puzzle, &successor) : successor.d2sol;
+    if (b < depth)
+      // recursive call, returns the minimal distance of successor to solution.
+      b = recurse (puzzle, &successor, depth - 1, board->inv_perm[move], buffer + 1);
+    // else don't try further because we have reached the depth limit.
 
-  if (nbChildren == 0)
-    return INT_MAX;
+    // The minimal distance of puzzle to solution is the minimal distance of successor to solution plus one.
+    if (b >= 0 && b < INT_MAX)
+      b++;
 
-  NodeRBFS *first = 0;
-  if (nbChildren == 1)
-  {
-    first = &children[0];
-    while (first->node.solved == 0 && first->F <= max_depth)
+    if (successor.solved < 0)
     {
-#ifdef TEST_CANCELLATION_POINT
-      if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-          && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-        pthread_cancel (*thread_cancellation_point_test);
-#endif
-      first->F =
-        // Cancellation point
-        // recursive call
-        sliding_puzzle_best_first_recursive_search (first, /* depth = */ depth + 1, /* V = */ first->F, max_depth,
-                                                    pBuffer, pBufferLength);
+      node->solved = successor.solved;
+      return INT_MAX;
     }
-  }
-  else
-  {
-    // Loop until puzzle is solved
-    while (1)
+    else if (successor.solved > 0)      // If solved
     {
-      // Find first and second node, sorted by increasing F
-      first = &children[0];
-      NodeRBFS *second = &children[1];
-      if (children[1].F < children[0].F)
-      {
-        first = &children[1];
-        second = &children[0];
-      }
-      for (int i = 2; i < nbChildren; i++)
-        if (children[i].F < first->F)
-        {
-          second = first;
-          first = &children[i];
-        }
-        else if (children[i].F < second->F)
-          second = &children[i];
-
-      if (first->F > max_depth)
-        break;
+      node->solved = successor.solved;
+      return b;
+    }
 
-#ifdef TEST_CANCELLATION_POINT
-      if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-          && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-        pthread_cancel (*thread_cancellation_point_test);
-#endif
-      // max_depth = min (second->F, max_depth)
-      if (second->F < max_depth)
-        first->F =
-          // Cancellation point
-          // recursive call
-          sliding_puzzle_best_first_recursive_search (first, /* depth = */ depth + 1, /* V = */ first->F,
-                                                      /* max_depth = */ second->F, pBuffer, pBufferLength);
-      else
-        first->F =
-          // Cancellation point
-          // recursive call
-          sliding_puzzle_best_first_recursive_search (first, /* depth = */ depth + 1, /* V = */ first->F, max_depth,
-                                                      pBuffer, pBufferLength);
+    // In case finding a solution for successor would require more than INT_MAX moves (most unlikely)
+    // give up for this try and try other another move.
+    if (b < 0)
+      continue;
 
-      if (first->node.solved)
-        break;
-    }
+    if (b < next_depth)
+      next_depth = b;
+    // Not solved yet. Continue the loop for the next authorized move.
   }
 
-  // Solved
-  N->node.solved = first->node.solved;
-  (*pBuffer)[depth].move = first->move;
-
-  // Returns the distance of puzzle to solution.
-  int ret = first->F;
+  if (next_depth < INT_MAX)
+    return next_depth;          // Returns the smallest minimal distance to solution for all possible moves of tile
+  else
+    return -1;                  // In case finding a solution for puzzle would require more than INT_MAX moves (most unlikely)
+}
 
-  return ret;
+// Generic search, for any size of puzzle.
+static int
+sliding_puzzle_depth_first_recursive_search (Puzzle puzzle, struct sNode *node, int depth, int last,
+                                             struct BufferIDA *buffer)
+{
+  return sliding_puzzle_depth_first_recursive_search_kernel (puzzle, node, depth, last, buffer, puzzle->width,
+                                                             puzzle->height, sliding_puzzle_depth_first_recursive_search);
 }
 
-/** Optimized solution searches algorithms - END **/
+// Specialized searches, for the most common sizes of puzzles.
+#define SLIDING_PUZZLE_DFRS_SPECIALIZE(width, height) \
+  static int \
+  sliding_puzzle_depth_first_recursive_search_##width##x##height (Puzzle puzzle, struct sNode *node, int depth, int last, \
+                                                                  struct BufferIDA *buffer) \
+  { \
+    return sliding_puzzle_depth_first_recursive_search_kernel (puzzle, node, depth, last, buffer, width, height, \
+                                                               sliding_puzzle_depth_first_recursive_search_##width##x##height); \
+  }
 
-/** Sliding puzzle toolbox - END **/
+// *INDENT-OFF*
+SLIDING_PUZZLE_DFRS_SPECIALIZE (3, 3)
+SLIDING_PUZZLE_DFRS_SPECIALIZE (4, 4)
+SLIDING_PUZZLE_DFRS_SPECIALIZE (5, 5)
+SLIDING_PUZZLE_DFRS_SPECIALIZE (6, 6)
+// *INDENT-ON*
 
-/** User interface - BEGIN **/
+/** Bitboard DFRS **/
+// A 4x4 puzzle fits in two 64-bit words of 4-bit nibbles: the tile at each position, and the position of each tile
+// (nibble 0 is the empty position). A move swaps nibbles in both words: nodes are passed by value, in registers,
+// and grids are never copied. The status of the search is held by the root node.
+#define BITBOARD_NIBBLE(word, i) ((int) (((word) >> (4 * (i))) & 0xF))
 
-/** Helpers - BEGIN **/
-Puzzle
-sliding_puzzle_init4 (int width, int height, int *grid, FILE * f)
+static int
+sliding_puzzle_bitboard_search (Puzzle puzzle, struct sNode *root, uint64_t grid, uint64_t pos, int d2sol,
+                                const int *d2patterns, const ACState (char) * state, int depth, int last, struct BufferIDA *buffer)
 {
-  // Check grid validity
-  if (width <= 0 || height <= 0 || width * height < 2)
+  // Solved ?
+  if (d2sol == 0)
+  {
+    root->solved = 1;
     return 0;
+  }
 
-  if (grid)
-    for (int i = 0; i < width * height; i++)
-    {
-      if (grid[i] < 0 || grid[i] >= width * height)
-        return 0;
-      else
-        for (int j = i + 1; j < width * height; j++)
-          if (grid[i] == grid[j])
-            return 0;
-    }
+  const struct sBoard *board = puzzle->board;
+  int finalpos = BITBOARD_NIBBLE (pos, 0);      // blank initial position = final tile position
+  int first_move = 0;
+  if (finalpos > 0)
+    first_move = board->upper_nb_perms[finalpos - 1];
+  int last_move = board->upper_nb_perms[finalpos];
 
-  Puzzle puzzle = malloc (sizeof (*puzzle));
-  puzzle->width = width;
-  puzzle->height = height;
-  puzzle->orient = 0;
-  puzzle->cycle_database = 0;
-  puzzle->cycle_state = 0;
-  puzzle->heuristic_database = 0;
-  puzzle->stream = f;
-  puzzle->solution_shower = 0;
+  int next_depth = INT_MAX;
 
-  // Target solution for an odd grid :
-  // - ascending from 0 to (width * height - 1)
+  int moves[4], tiles[4], from[4], d2sols[4], successor_d2patterns[4][2];
+  const ACState (char) * states[4];
+  int nb_children = 0;
+
+  // Loop on authorized moves (see sliding_puzzle_depth_first_recursive_search_kernel).
+  for (int move = first_move; move < last_move; move++)
+  {
+    int initpos = board->pos_perm[move];        // initial tile position = blank final position
+
+    const ACState (char) * s = state;
+    if (s)                      // If a cycle bank is defined
+    {
+      int li = initpos >> 2;    // line of initial tile position
+      int ci = initpos & 3;     // column ...
+
+      // Check if the last moves would be a cycle (non efficient moves).
+      ZoneExtension *z = 0;
+      if (ACM_match (s, board->dir_perm[move]))
+      {
+        void *v;
+        ACM_get_match (s, 0, 0, &v);
+        z = v;
+      }
+
+      if (z && (z->lmin + li >= 0) && (z->lmax + li < 4) && (z->cmin + ci >= 0) && (z->cmax + ci < 4))
+        continue;
+    }
+    else if (move == last)
+      continue;
+
+    moves[nb_children] = move;
+    tiles[nb_children] = BITBOARD_NIBBLE (grid, initpos);
+    from[nb_children] = initpos;
+    states[nb_children] = s;
+    nb_children++;
+  }
+
+  if (puzzle->heuristic_database)
+    sliding_puzzle_heuristic_children_kernel (puzzle->heuristic_database, &pos, 16, 0, d2patterns, nb_children, tiles,
+                                              from, finalpos, successor_d2patterns, d2sols);
+
+  for (int c = 0; c < nb_children; c++)
+  {
+    int move = moves[c];
+    int initpos = from[c];      // initial tile position = blank final position
+    int tile = tiles[c];
+
+    buffer->move = initpos - finalpos;  // blank tile move
+
+    buffer->nbGeneratedNodes++;
+    if (!(buffer->nbGeneratedNodes % PROGRESS_NODES_GRANULARITY))
+    {
+      if (puzzle->progress)
+        atomic_fetch_add_explicit (&puzzle->progress->nodes, PROGRESS_NODES_GRANULARITY, memory_order_relaxed);
+      // Abandoned search
+      if (puzzle->stop && atomic_load_explicit (puzzle->stop, memory_order_relaxed))
+      {
+        root->solved = -1;
+        return INT_MAX;
+      }
+    }
+
+    // Move blank tile: the tile takes the empty position, which was nibble 0 of the grid.
+    uint64_t successor_grid = (grid & ~((uint64_t) 0xF << (4 * initpos))) | ((uint64_t) tile << (4 * finalpos));
+    uint64_t successor_pos = (pos & ~((uint64_t) 0xF << (4 * tile)) & ~(uint64_t) 0xF)
+      | ((uint64_t) finalpos << (4 * tile)) | (uint64_t) initpos;
+
+    int successor_d2sol;
+    if (puzzle->heuristic_database)
+      successor_d2sol = d2sols[c];
+    else
+      // Update Manhattan distance: the tile moves from initpos to finalpos.
+      successor_d2sol = d2sol + board->manhattan[tile * 16 + finalpos] - board->manhattan[tile * 16 + initpos];
+
+    int b = successor_d2sol;
+    if (b < depth)
+      b = sliding_puzzle_bitboard_search (puzzle, root, successor_grid, successor_pos, successor_d2sol,
+                                          successor_d2patterns[c], states[c], depth - 1, board->inv_perm[move],
+                                          buffer + 1);
+
+    if (b >= 0 && b < INT_MAX)
+      b++;
+
+    if (root->solved < 0)
+      return INT_MAX;
+    else if (root->solved > 0)  // If solved
+      return b;
+
+    if (b < 0)
+      continue;
+
+    if (b < next_depth)
+      next_depth = b;
+  }
+
+  if (next_depth < INT_MAX)
+    return next_depth;
+  else
+    return -1;
+}
+
+static int
+sliding_puzzle_depth_first_recursive_search_bitboard (Puzzle puzzle, struct sNode *node, int depth, int last,
+                                                      struct BufferIDA *buffer)
+{
+  const uint8_t *node_grid = node->grid, *node_pos = node->pos;
+  uint64_t grid = 0, pos = 0;
+  for (int i = 0; i < 16; i++)
+  {
+    grid |= (uint64_t) node_grid[i] << (4 * i);
+    pos |= (uint64_t) node_pos[i] << (4 * i);
+  }
+
+  node->solved = 0;
+  return sliding_puzzle_bitboard_search (puzzle, node, grid, pos, node->d2sol, node->d2patterns, node->cycle_state, depth,
+                                         last, buffer);
+}
+
+// Selects the search for the size of the puzzle, once per solve.
+static SearchDFRS
+sliding_puzzle_depth_first_recursive_search_select (constPuzzle puzzle)
+{
+  if (puzzle->width == 3 && puzzle->height == 3)
+    return sliding_puzzle_depth_first_recursive_search_3x3;
+  // The bitboard search does not handle perimeters nor cycling puzzles (which are never 4x4 anyway).
+  if (puzzle->width == 4 && puzzle->height == 4 && !puzzle->perimeter_database && !puzzle->orient)
+    return sliding_puzzle_depth_first_recursive_search_bitboard;
+  if (puzzle->width == 4 && puzzle->height == 4)
+    return sliding_puzzle_depth_first_recursive_search_4x4;
+  if (puzzle->width == 5 && puzzle->height == 5)
+    return sliding_puzzle_depth_first_recursive_search_5x5;
+  if (puzzle->width == 6 && puzzle->height == 6)
+    return sliding_puzzle_depth_first_recursive_search_6x6;
+  return sliding_puzzle_depth_first_recursive_search;
+}
+
+static HeuristicDatabase sliding_puzzle_heuristic_database_local (HeuristicDatabase database);
+
+/** Parallel window DFRS **/
+// Threads run whole iterations of IDA* concurrently, with successive thresholds t, t + 2, t + 4...
+// (the length of the solutions has the parity of the distance of the blank to its target position, 0).
+// The solution found with the smallest threshold is optimal, once all the smaller thresholds failed.
+struct sWindowThread
+{
+  pthread_t thread;
+  int threshold;                // being searched, 0 if none
+  atomic_int stop;              // set to abandon the threshold being searched
+};
+
+struct sWindowIDA
+{
+  pthread_mutex_t mutex;
+  Puzzle puzzle;
+  int next_threshold;           // next threshold to search
+  int solved_threshold;         // smallest threshold that found a solution, INT_MAX if none
+  int length;
+  int *solution;
+  uintmax_t *nodes;             // generated nodes per depth, for all threads
+  int nodes_length;
+  struct sWindowThread *threads;
+  int nb_threads;
+  int nb_started;
+  int nb_joined;
+  int nb_running;               // to assign a slot to each thread
+};
+
+static void
+sliding_puzzle_window_IDA_cleanup (void *arg)
+{
+  struct sWindowIDA *w = arg;
+  // No more thresholds, and the ones being searched are abandoned.
+  pthread_mutex_lock (&w->mutex);
+  w->solved_threshold = 0;
+  for (int i = 0; i < w->nb_threads; i++)
+    atomic_store_explicit (&w->threads[i].stop, 1, memory_order_relaxed);
+  pthread_mutex_unlock (&w->mutex);
+  for (int i = w->nb_joined; i < w->nb_started; i++)
+    pthread_cancel (w->threads[i].thread);
+  for (int i = w->nb_joined; i < w->nb_started; i++)
+    pthread_join (w->threads[i].thread, 0);
+  free (w->threads);
+  free (w->solution);
+  free (w->nodes);
+  pthread_mutex_destroy (&w->mutex);
+}
+
+// Thread cancellable (between thresholds)
+static void *
+sliding_puzzle_window_IDA_worker (void *arg)
+{
+  struct sWindowIDA *w = arg;
+  Puzzle puzzle = w->puzzle;
+  int n = puzzle->width * puzzle->height;
+
+  ASSERT_FALSE (pthread_mutex_lock (&w->mutex), _("POSIX thread error"));
+  struct sWindowThread *self = &w->threads[w->nb_running++];
+  ASSERT_FALSE (pthread_mutex_unlock (&w->mutex), _("POSIX thread error"));
+
+  // The puzzle is shared by the threads and copied: levels are displayed by the caller, and each thread has its own stop.
+  struct sPuzzle problem = *puzzle;
+  problem.stream = 0;
+  problem.stop = &self->stop;
+  problem.heuristic_database = sliding_puzzle_heuristic_database_local (puzzle->heuristic_database);
+  SearchDFRS search = sliding_puzzle_depth_first_recursive_search_select (&problem);
+
+  // Buffering to avoid allocations during recursion
+  struct BufferIDA *buffer = 0;
+  int bufferLength = 0;
+  struct BuffersIDA b;
+  b.pBuffer = &buffer;
+  b.pBufferLength = &bufferLength;
+  pthread_cleanup_push (sliding_puzzle_buffer_IDA_cleanup, &b);
+
+  struct sNode root = { 0 };
+  pthread_cleanup_push (sliding_puzzle_node_cleanup, &root);
+  sliding_puzzle_node_init (puzzle, &root);
+
+  while (1)
+  {
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
+    // Cancellation point
+    pthread_testcancel ();
+
+    ASSERT_FALSE (pthread_mutex_lock (&w->mutex), _("POSIX thread error"));
+    int threshold = w->next_threshold;
+    if (threshold < w->solved_threshold && threshold < INT_MAX - 2)
+    {
+      w->next_threshold += 2;
+      self->threshold = threshold;
+      atomic_store_explicit (&self->stop, 0, memory_order_relaxed);
+    }
+    else
+      threshold = 0;
+    ASSERT_FALSE (pthread_mutex_unlock (&w->mutex), _("POSIX thread error"));
+    if (!threshold)
+      break;
+
+    PUZZLE_PRINT (puzzle, "%i.", threshold);
+    sliding_puzzle_progress_iteration (puzzle, threshold, threshold, 0);
+
+    if (threshold > bufferLength)
+    {
+      buffer = realloc (buffer, threshold * sizeof (*buffer));
+      for (int i = bufferLength; i < threshold; i++)
+      {
+        buffer[i].grid = malloc (n * NODE_CELL (n));  // needs cancel cleanup
+        buffer[i].pos = malloc (n * NODE_CELL (n));   // needs cancel cleanup
+        buffer[i].nbGeneratedNodes = 0;
+      }
+      bufferLength = threshold;
+    }
+
+    root.solved = 0;
+    if (problem.cycle_database)
+      root.cycle_state = ACM_reset (problem.cycle_database->cycles);
+    int length = search (&problem, &root, threshold, -1, buffer);
+
+    ASSERT_FALSE (pthread_mutex_lock (&w->mutex), _("POSIX thread error"));
+    self->threshold = 0;
+    if (root.solved > 0 && threshold < w->solved_threshold)
+    {
+      w->solved_threshold = threshold;
+      w->length = length;
+      CHECK_ALLOC (w->solution = realloc (w->solution, length * sizeof (*w->solution)));
+      for (int i = 0; i < length; i++)
+        w->solution[i] = buffer[i].move;
+      // Larger thresholds can not find a shorter solution.
+      for (int i = 0; i < w->nb_threads; i++)
+        if (w->threads[i].threshold > threshold)
+          atomic_store_explicit (&w->threads[i].stop, 1, memory_order_relaxed);
+    }
+    else if (!root.solved && length > threshold)
+    {
+      // No puzzle has a distance between 'threshold' and 'length': the thresholds in between would fail as well.
+      if (length > INT_MAX - 2)
+        length = INT_MAX - 2;
+      if ((length - threshold) % 2)
+        length++;
+      if (w->next_threshold < length)
+        w->next_threshold = length;
+      for (int i = 0; i < w->nb_threads; i++)
+        if (w->threads[i].threshold > threshold && w->threads[i].threshold < length)
+          atomic_store_explicit (&w->threads[i].stop, 1, memory_order_relaxed);
+    }
+    ASSERT_FALSE (pthread_mutex_unlock (&w->mutex), _("POSIX thread error"));
+  }
+
+  ASSERT_FALSE (pthread_mutex_lock (&w->mutex), _("POSIX thread error"));
+  if (bufferLength > w->nodes_length)
+  {
+    CHECK_ALLOC (w->nodes = realloc (w->nodes, bufferLength * sizeof (*w->nodes)));
+    memset (w->nodes + w->nodes_length, 0, (bufferLength - w->nodes_length) * sizeof (*w->nodes));
+    w->nodes_length = bufferLength;
+  }
+  for (int i = 0; i < bufferLength; i++)
+    w->nodes[i] += buffer[i].nbGeneratedNodes;
+  ASSERT_FALSE (pthread_mutex_unlock (&w->mutex), _("POSIX thread error"));
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_node_cleanup
+  pthread_cleanup_pop (1);      // sliding_puzzle_buffer_IDA_cleanup
+
+  return 0;
+}
+
+// Copies the solution of the window and its generated nodes per depth into '*pBuffer'. Returns the length of the solution.
+// Out of line: its loops do not run within the cleanup scope of sliding_puzzle_window_depth_first_search.
+static __attribute__ ((noinline)) int
+sliding_puzzle_window_result (const struct sWindowIDA *w, struct BufferIDA **pBuffer, int *pBufferLength)
+{
+  int length = w->length;
+  if (length > *pBufferLength)
+  {
+    CHECK_ALLOC (*pBuffer = realloc (*pBuffer, length * sizeof (**pBuffer)));
+    memset (*pBuffer + *pBufferLength, 0, (length - *pBufferLength) * sizeof (**pBuffer));
+    *pBufferLength = length;
+  }
+  for (int i = 0; i < length; i++)
+  {
+    (*pBuffer)[i].move = w->solution[i];
+    (*pBuffer)[i].nbGeneratedNodes = i < w->nodes_length ? w->nodes[i] : 0;
+  }
+  for (int i = length; i < w->nodes_length; i++)
+    (*pBuffer)[length - 1].nbGeneratedNodes += w->nodes[i];
+
+  return length;
+}
+
+// Thread cancellable
+// Same as the iterations of sliding_puzzle_solve_IDA from 'threshold', on 'nb_threads' threads.
+// The moves of the solution and the generated nodes per depth are returned in '*pBuffer', of the length of the solution
+// (the nodes generated deeper by larger thresholds are accounted to the last depth). Returns the length of the solution, or -1.
+static int
+sliding_puzzle_window_depth_first_search (Puzzle puzzle, int threshold, int nb_threads, struct BufferIDA **pBuffer,
+                                          int *pBufferLength)
+{
+  int volatile length = -1;
+  struct sWindowIDA w = {.puzzle = puzzle,.solved_threshold = INT_MAX,.nb_threads = nb_threads };
+  pthread_mutex_init (&w.mutex, 0);
+  CHECK_ALLOC (w.threads = calloc (nb_threads, sizeof (*w.threads)));
+  pthread_cleanup_push (sliding_puzzle_window_IDA_cleanup, &w);
+
+  // Thresholds with the parity of the solutions
+  w.next_threshold = threshold;
+  if ((w.next_threshold + puzzle->pos[0] / puzzle->width + puzzle->pos[0] % puzzle->width) % 2)
+    w.next_threshold++;
+
+  // The calling thread only waits for the others: cancelling it abandons the searches at once.
+  for (; w.nb_started < nb_threads; w.nb_started++)
+    if (pthread_create (&w.threads[w.nb_started].thread, 0, sliding_puzzle_window_IDA_worker, &w))
+      break;
+  if (!w.nb_started)
+    // Cancellation point
+    sliding_puzzle_window_IDA_worker (&w);
+  for (; w.nb_joined < w.nb_started; w.nb_joined++)
+    // Cancellation point
+    pthread_join (w.threads[w.nb_joined].thread, 0);
+
+  if (w.solved_threshold < INT_MAX)
+    length = sliding_puzzle_window_result (&w, pBuffer, pBufferLength);
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_window_IDA_cleanup
+
+  return length;
+}
+
+/** BFRS **/
+// Search kernel, specialized as sliding_puzzle_depth_first_recursive_search_kernel.
+static inline __attribute__ ((always_inline)) int
+sliding_puzzle_best_first_recursive_search_kernel (Puzzle puzzle, NodeRBFS * N, int depth, int V, int max_depth,
+                                                   struct BufferRBFS **pBuffer, int *pBufferLength, const int width,
+                                                   const int height, SearchBFRS recurse)
+{
+  const int size = width * height;
+  const int cell = NODE_CELL (size);
+  const struct sBoard *board = puzzle->board;
+  struct sNode *node = &N->node;
+  // Solved ?
+  int h_node = node->d2sol;
+  if (h_node == 0)
+  {
+    node->solved = 1;
+    return depth;
+  }
+
+  // Minimal distance (depth + h_node) is larger than INT_MAX : abort (most unlikely)
+  if (h_node > INT_MAX - depth)
+  {
+    node->solved = -1;
+    return INT_MAX;
+  }
+
+  // If the minimal distance to solution (depth + h_node) is higher than the searched solution length
+  // return the minimal distance to solution.
+  if (h_node > max_depth - depth)
+    return depth + h_node;
+
+  if (depth >= *pBufferLength)
+  {
+    *pBuffer = realloc (*pBuffer, (depth + 1) * sizeof (**pBuffer));
+    for (int i = *pBufferLength; i < depth + 1; i++)
+      for (int c = 0; c < 4; c++)
+      {
+        (*pBuffer)[i].grid[c] = malloc (size * cell);    // needs cancel cleanup
+        (*pBuffer)[i].pos[c] = malloc (size * cell);     // needs cancel cleanup
+        (*pBuffer)[i].nbGeneratedNodes = 0;
+      }
+    *pBufferLength = depth + 1;
+    PUZZLE_PRINT (puzzle, "%i.", depth + 1);
+    sliding_puzzle_progress_iteration (puzzle, depth + 1, V, 0);
+
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
+    // Cancellation point
+    pthread_testcancel ();
+  }
+
+  int first_move = 0;
+  int blank = sliding_puzzle_cell_get (node->pos, 0, cell);
+  if (blank > 0)
+    first_move = board->upper_nb_perms[blank - 1];
+  int last_move = board->upper_nb_perms[blank];
+
+  NodeRBFS children[4];
+  int nbChildren = 0;
+  int tiles[4], from[4], d2sol[4], d2patterns[4][2];
+
+  // Loop on authorized moves.
+  // Try every authorized move for tile 0 (empty position).
+  // upper_nb_perms[i] is is the number of possible moves for tiles for which position is between 0 and position i.
+  // pos_perm, with index from 0 to nb_perms[i] (excluded) is the list of those authorized moves.
+  for (int move = first_move; move < last_move; move++)
+  {
+    int initpos = board->pos_perm[move];        // blank final position
+    int tile = sliding_puzzle_cell_get (node->grid, initpos, cell);
+
+    int finalpos = blank;       // blank initial position
+    int m = initpos - finalpos; // blank tile move
+
+    int li = initpos / width;
+    int ci = initpos % width;
+
+    int orient = 0;
+
+    const ACState (char) * s = node->cycle_state;
+    if (s)                      // If a cycle bank is defined
+    {
+      if ((orient = node->orient))      // assignation here, not comparison.
+        // True only for cycling puzzles, not standard puzzles.
+      {
+        if (initpos - finalpos == width)
+          continue;
+        orient = 0;
+      }
+
+      // Check if the last moves would be a cycle (non efficient moves).
+      // Update state machine with blank tile move
+      ZoneExtension *z = 0;
+      if (ACM_match (s, board->dir_perm[move]))
+      {
+        void *v;
+        ACM_get_match (s, 0, 0, &v);
+        z = v;
+      }
+
+      // If the last moves describe a cycle not hitting edges of the puzzle,
+      // then the last move is useless and not tried further.
+      if (z && (z->lmin + li >= 0) && (z->lmax + li < height) && (z->cmin + ci >= 0)
+          && (z->cmax + ci < width))
+        continue;
+    }
+    // If the last moves is the opposite of the previous one,
+    // then the last move is useless and not tried further.
+    else if (m == -N->move)
+      continue;
+
+    nbChildren++;
+    children[nbChildren - 1].node = *node;
+    children[nbChildren - 1].move = m;
+
+    (*pBuffer)[depth].nbGeneratedNodes++;
+    if (!((*pBuffer)[depth].nbGeneratedNodes % PROGRESS_NODES_GRANULARITY))
+    {
+      if (puzzle->progress)
+        atomic_fetch_add_explicit (&puzzle->progress->nodes, PROGRESS_NODES_GRANULARITY, memory_order_relaxed);
+      // Abandoned search
+      if (puzzle->stop && atomic_load_explicit (puzzle->stop, memory_order_relaxed))
+      {
+        N->node.solved = -1;
+        return INT_MAX;
+      }
+    }
+
+    // Copy constructor
+    struct sNode *successor = &children[nbChildren - 1].node;
+    successor->orient = orient;
+    successor->grid = (*pBuffer)[depth].grid[nbChildren - 1];
+    memcpy (successor->grid, node->grid, size * cell);
+    successor->pos = (*pBuffer)[depth].pos[nbChildren - 1];
+    memcpy (successor->pos, node->pos, size * cell);
+    successor->cycle_state = s;
+
+    // Move blank tile
+    sliding_puzzle_cell_set (successor->grid, initpos, 0, cell);
+    sliding_puzzle_cell_set (successor->grid, finalpos, tile, cell);
+    sliding_puzzle_cell_set (successor->pos, 0, initpos, cell);
+    sliding_puzzle_cell_set (successor->pos, tile, finalpos, cell);
+
+    tiles[nbChildren - 1] = tile;
+    from[nbChildren - 1] = initpos;
+
+    // With a heuristic database, children are evaluated all together below.
+    if (puzzle->heuristic_database)
+      continue;
+    else if (size <= BOARD_MANHATTAN_MAX_SIZE)
+      // Update Manhattan distance: the tile moves from initpos to finalpos.
+      successor->d2sol += board->manhattan[tile * size + finalpos] - board->manhattan[tile * size + initpos];
+    else
+    {
+      // Recompute Manhattan distance
+      int lf = finalpos / width;
+      int cf = finalpos % width;
+
+      int delta_line, delta_col;
+      int vs1 = puzzle->pos_sol[tile];
+      int ls1 = vs1 / width;
+      int cs1 = vs1 % width;
+
+      delta_line = li > ls1 ? li - ls1 : ls1 - li;
+      delta_col = ci > cs1 ? ci - cs1 : cs1 - ci;
+      successor->d2sol -= delta_line + delta_col;
+      delta_line = lf > ls1 ? lf - ls1 : ls1 - lf;
+      delta_col = cf > cs1 ? cf - cs1 : cs1 - cf;
+      successor->d2sol += delta_line + delta_col;
+    }
+  }
+
+  if (nbChildren == 0)
+    return INT_MAX;
+
+  // All the children are evaluated together (see sliding_puzzle_heuristic_children_kernel).
+  if (puzzle->heuristic_database)
+  {
+    sliding_puzzle_heuristic_children_kernel (puzzle->heuristic_database, node->pos, size, cell, node->d2patterns,
+                                              nbChildren, tiles, from, blank, d2patterns, d2sol);
+    for (int c = 0; c < nbChildren; c++)
+    {
+      children[c].node.d2sol = d2sol[c];
+      children[c].node.d2patterns[0] = d2patterns[c][0];
+      children[c].node.d2patterns[1] = d2patterns[c][1];
+    }
+  }
+
+  for (int c = 0; c < nbChildren; c++)
+  {
+    // Minimal distance of initial puzzle to solution after the extra move
+    children[c].F = depth + 1 + children[c].node.d2sol;
+
+    // Minimal distance of initial puzzle to solution before the extra move
+    int f = depth + h_node;
+
+    // If both minimal distance (before and after move) are lower than V, then
+    // the minimal is kept identical to the previous depth of iteration.
+    if (children[c].F < V && f < V)
+      children[c].F = V;
+  }
+
+  NodeRBFS *first = 0;
+  if (nbChildren == 1)
+  {
+    first = &children[0];
+    while (first->node.solved == 0 && first->F <= max_depth)
+    {
+#ifdef TEST_CANCELLATION_POINT
+      if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+          && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+        pthread_cancel (*thread_cancellation_point_test);
+#endif
+      first->F =
+        // Cancellation point
+        // recursive call
+        recurse (puzzle, first, /* depth = */ depth + 1, /* V = */ first->F, max_depth, pBuffer, pBufferLength);
+    }
+  }
+  else
+  {
+    // Loop until puzzle is solved
+    while (1)
+    {
+      // Find first and second node, sorted by increasing F
+      first = &children[0];
+      NodeRBFS *second = &children[1];
+      if (children[1].F < children[0].F)
+      {
+        first = &children[1];
+        second = &children[0];
+      }
+      for (int i = 2; i < nbChildren; i++)
+        if (children[i].F < first->F)
+        {
+          second = first;
+          first = &children[i];
+        }
+        else if (children[i].F < second->F)
+          second = &children[i];
+
+      if (first->F > max_depth)
+        break;
+
+      if (depth == 0 && puzzle->progress)
+        atomic_store_explicit (&puzzle->progress->f_bound, first->F, memory_order_relaxed);
+
+#ifdef TEST_CANCELLATION_POINT
+      if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+          && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+        pthread_cancel (*thread_cancellation_point_test);
+#endif
+      // max_depth = min (second->F, max_depth)
+      if (second->F < max_depth)
+        first->F =
+          // Cancellation point
+          // recursive call
+          recurse (puzzle, first, /* depth = */ depth + 1, /* V = */ first->F, /* max_depth = */ second->F, pBuffer, pBufferLength);
+      else
+        first->F =
+          // Cancellation point
+          // recursive call
+          recurse (puzzle, first, /* depth = */ depth + 1, /* V = */ first->F, max_depth, pBuffer, pBufferLength);
+
+      if (first->node.solved)
+        break;
+    }
+  }
+
+  // Solved
+  N->node.solved = first->node.solved;
+  (*pBuffer)[depth].move = first->move;
+
+  // Returns the distance of puzzle to solution.
+  int ret = first->F;
+
+  return ret;
+}
+
+// Generic search, for any size of puzzle.
+static int
+sliding_puzzle_best_first_recursive_search (Puzzle puzzle, NodeRBFS * N, int depth, int V, int max_depth,
+                                            struct BufferRBFS **pBuffer, int *pBufferLength)
+{
+  return sliding_puzzle_best_first_recursive_search_kernel (puzzle, N, depth, V, max_depth, pBuffer, pBufferLength,
+                                                            puzzle->width, puzzle->height,
+                                                            sliding_puzzle_best_first_recursive_search);
+}
+
+// Specialized searches, for the most common sizes of puzzles.
+#define SLIDING_PUZZLE_BFRS_SPECIALIZE(width, height) \
+  static int \
+  sliding_puzzle_best_first_recursive_search_##width##x##height (Puzzle puzzle, NodeRBFS * N, int depth, int V, \
+                                                                 int max_depth, struct BufferRBFS **pBuffer, \
+                                                                 int *pBufferLength) \
+  { \
+    return sliding_puzzle_best_first_recursive_search_kernel (puzzle, N, depth, V, max_depth, pBuffer, pBufferLength, \
+                                                              width, height, \
+                                                              sliding_puzzle_best_first_recursive_search_##width##x##height); \
+  }
+
+// *INDENT-OFF*
+SLIDING_PUZZLE_BFRS_SPECIALIZE (3, 3)
+SLIDING_PUZZLE_BFRS_SPECIALIZE (4, 4)
+SLIDING_PUZZLE_BFRS_SPECIALIZE (5, 5)
+SLIDING_PUZZLE_BFRS_SPECIALIZE (6, 6)
+// *INDENT-ON*
+
+// Selects the search for the size of the puzzle, once per solve.
+static SearchBFRS
+sliding_puzzle_best_first_recursive_search_select (constPuzzle puzzle)
+{
+  if (puzzle->width == 3 && puzzle->height == 3)
+    return sliding_puzzle_best_first_recursive_search_3x3;
+  if (puzzle->width == 4 && puzzle->height == 4)
+    return sliding_puzzle_best_first_recursive_search_4x4;
+  if (puzzle->width == 5 && puzzle->height == 5)
+    return sliding_puzzle_best_first_recursive_search_5x5;
+  if (puzzle->width == 6 && puzzle->height == 6)
+    return sliding_puzzle_best_first_recursive_search_6x6;
+  return sliding_puzzle_best_first_recursive_search;
+}
+
+/** Parallel BFRS **/
+// The tree is first expanded breadth-first from the root into a frontier of subtrees, then the subtrees are searched
+// by RBFS on several threads, each with its own per-depth buffers. The subtree with the lowest F is searched first,
+// as RBFS would do at the root, up to F = lowest F over all open subtrees + PARALLEL_RBFS_SPECULATION: threads never run
+// further ahead of the best-first order. A solution is optimal once every other subtree is known to be at least as long.
+#define PARALLEL_RBFS_SUBTREES 16       // per thread
+#define PARALLEL_RBFS_SPECULATION 2     // one level of the puzzle (distances of a puzzle have all the same parity)
+
+struct sSubtreeRBFS
+{
+  NodeRBFS node;                // root of the subtree (own grid and positions)
+  int depth;
+  int *moves;                   // path from the root of the search to the root of the subtree
+  int claimed;                  // being searched by a thread
+};
+
+struct sParallelRBFS
+{
+  struct sPuzzle problem;       // shared by the threads, levels are displayed by the caller, not by each thread
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  struct sSubtreeRBFS *subtrees;
+  int nb_subtrees;
+  int nb_claimed;
+  int best;                     // length of the shortest solution found so far, INT_MAX if none
+  int *solution;
+  uintmax_t *nodes;             // generated nodes per depth, for all threads
+  int nodes_length;
+  pthread_t *threads;
+  int nb_started;
+};
+
+static void
+sliding_puzzle_parallel_RBFS_unlock (void *arg)
+{
+  struct sParallelRBFS *p = arg;
+  pthread_mutex_unlock (&p->mutex);
+}
+
+static void
+sliding_puzzle_subtrees_RBFS_free (struct sSubtreeRBFS *subtrees, int nb_subtrees)
+{
+  for (int i = 0; i < nb_subtrees; i++)
+  {
+    free (subtrees[i].node.node.grid);
+    free (subtrees[i].node.node.pos);
+    free (subtrees[i].moves);
+  }
+  free (subtrees);
+}
+
+// Cleaner for the parallel search: stops the threads still running (on cancellation), and frees the search.
+static void
+sliding_puzzle_parallel_RBFS_cleanup (void *arg)
+{
+  struct sParallelRBFS *p = arg;
+  for (int i = 0; i < p->nb_started; i++)
+    pthread_cancel (p->threads[i]);
+  for (int i = 0; i < p->nb_started; i++)
+    pthread_join (p->threads[i], 0);
+  free (p->threads);
+  sliding_puzzle_subtrees_RBFS_free (p->subtrees, p->nb_subtrees);
+  free (p->solution);
+  free (p->nodes);
+  pthread_cond_destroy (&p->changed);
+  pthread_mutex_destroy (&p->mutex);
+}
+
+// Needs the mutex.
+// Returns the subtree to search next, and the bound of the search in '*max_depth', or 0 if no subtree can be searched for now.
+static struct sSubtreeRBFS *
+sliding_puzzle_parallel_RBFS_claim (struct sParallelRBFS *p, int *max_depth)
+{
+  int lowest = INT_MAX;         // lowest F of open subtrees, a lower bound of the length of the solution
+  struct sSubtreeRBFS *next = 0;
+  for (int i = 0; i < p->nb_subtrees; i++)
+  {
+    struct sSubtreeRBFS *s = &p->subtrees[i];
+    if (s->node.F >= p->best)
+      continue;
+    if (s->node.F < lowest)
+      lowest = s->node.F;
+    if (!s->claimed && (!next || s->node.F < next->node.F))
+      next = s;
+  }
+
+  if (!next || next->node.F - lowest > PARALLEL_RBFS_SPECULATION)
+    return 0;
+
+  *max_depth = lowest > INT_MAX - PARALLEL_RBFS_SPECULATION ? INT_MAX : lowest + PARALLEL_RBFS_SPECULATION;
+  if (*max_depth >= p->best)
+    *max_depth = p->best - 1;
+  next->claimed = 1;
+  p->nb_claimed++;
+
+  return next;
+}
+
+// Thread cancellable
+static void *
+sliding_puzzle_parallel_RBFS_worker (void *arg)
+{
+  struct sParallelRBFS *p = arg;
+
+  // Each thread looks up the heuristic tables of its NUMA node.
+  struct sPuzzle problem = p->problem;
+  problem.heuristic_database = sliding_puzzle_heuristic_database_local (p->problem.heuristic_database);
+
+  // Buffering to avoid allocations during recursion, reused from one subtree to the next.
+  struct BufferRBFS *buffer = 0;
+  int bufferLength = 0;
+  struct BuffersRBFS b;
+  b.pBuffer = &buffer;
+  b.pBufferLength = &bufferLength;
+  pthread_cleanup_push (sliding_puzzle_buffer_RBFS_cleanup, &b);
+
+  while (1)
+  {
+    struct sSubtreeRBFS *s = 0;
+    int max_depth = 0;
+
+    ASSERT_FALSE (pthread_mutex_lock (&p->mutex), _("POSIX thread error"));
+    pthread_cleanup_push (sliding_puzzle_parallel_RBFS_unlock, p);
+    while (!(s = sliding_puzzle_parallel_RBFS_claim (p, &max_depth)) && p->nb_claimed)
+      // Cancellation point
+      ASSERT_FALSE (pthread_cond_wait (&p->changed, &p->mutex), _("POSIX thread error"));
+    pthread_cleanup_pop (1);    // sliding_puzzle_parallel_RBFS_unlock
+
+    if (!s)
+      break;
+
+    // Cancellation point
+    int F = sliding_puzzle_best_first_recursive_search_select (&problem) (&problem, &s->node, s->depth,
+                                                                          /* V = */ s->node.F, max_depth, &buffer,
+                                                                          &bufferLength);
+
+    ASSERT_FALSE (pthread_mutex_lock (&p->mutex), _("POSIX thread error"));
+    if (s->node.node.solved < 0)
+      F = INT_MAX;
+    else if (s->node.node.solved > 0 && F < p->best)
+    {
+      p->best = F;
+      CHECK_ALLOC (p->solution = realloc (p->solution, F * sizeof (*p->solution)));
+      memcpy (p->solution, s->moves, s->depth * sizeof (*p->solution));
+      for (int i = s->depth; i < F; i++)
+        p->solution[i] = buffer[i].move;
+    }
+    s->node.node.solved = 0;
+    s->node.F = F;
+    s->claimed = 0;
+    p->nb_claimed--;
+    ASSERT_FALSE (pthread_cond_broadcast (&p->changed), _("POSIX thread error"));
+    ASSERT_FALSE (pthread_mutex_unlock (&p->mutex), _("POSIX thread error"));
+  }
+
+  ASSERT_FALSE (pthread_mutex_lock (&p->mutex), _("POSIX thread error"));
+  if (bufferLength > p->nodes_length)
+  {
+    CHECK_ALLOC (p->nodes = realloc (p->nodes, bufferLength * sizeof (*p->nodes)));
+    memset (p->nodes + p->nodes_length, 0, (bufferLength - p->nodes_length) * sizeof (*p->nodes));
+    p->nodes_length = bufferLength;
+  }
+  for (int i = 0; i < bufferLength; i++)
+    p->nodes[i] += buffer[i].nbGeneratedNodes;
+  ASSERT_FALSE (pthread_mutex_unlock (&p->mutex), _("POSIX thread error"));
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_buffer_RBFS_cleanup
+
+  return 0;
+}
+
+// Thread cancellable
+// Same as sliding_puzzle_best_first_recursive_search from the root (depth 0, no bound), on 'nb_threads' threads.
+// The moves of the solution and the generated nodes per depth are returned in '*pBuffer'.
+static int
+sliding_puzzle_parallel_best_first_search (Puzzle puzzle, NodeRBFS * root, int nb_threads, struct BufferRBFS **pBuffer,
+                                           int *pBufferLength)
+{
+  int n = puzzle->width * puzzle->height;
+  int cell = NODE_CELL (n);
+
+  int length = INT_MAX;
+  struct sParallelRBFS p = {.nb_subtrees = 1,.best = INT_MAX };
+  pthread_mutex_init (&p.mutex, 0);
+  pthread_cond_init (&p.changed, 0);
+  CHECK_ALLOC (p.subtrees = calloc (1, sizeof (*p.subtrees)));
+  CHECK_ALLOC (p.threads = malloc (nb_threads * sizeof (*p.threads)));
+  pthread_cleanup_push (sliding_puzzle_parallel_RBFS_cleanup, &p);
+
+  p.problem = *puzzle;
+  p.problem.stream = 0;
+  p.subtrees[0].node = *root;
+  CHECK_ALLOC (p.subtrees[0].node.node.grid = malloc (n * cell));
+  memcpy (p.subtrees[0].node.node.grid, root->node.grid, n * cell);
+  CHECK_ALLOC (p.subtrees[0].node.node.pos = malloc (n * cell));
+  memcpy (p.subtrees[0].node.node.pos, root->node.pos, n * cell);
+
+  // Breadth-first expansion of the root, until there are enough subtrees to keep all the threads busy.
+  // Only the opposite of the last move is pruned here: cycles are pruned within the subtrees.
+  for (int depth = 0; p.best == INT_MAX && p.nb_subtrees < PARALLEL_RBFS_SUBTREES * nb_threads; depth++)
+  {
+    struct sSubtreeRBFS *subtrees;
+    int nb_subtrees = 0;
+    CHECK_ALLOC (subtrees = calloc (4 * p.nb_subtrees, sizeof (*subtrees)));
+    CHECK_ALLOC (p.nodes = realloc (p.nodes, (depth + 1) * sizeof (*p.nodes)));
+    p.nodes[depth] = 0;
+    p.nodes_length = depth + 1;
+
+    for (int i = 0; i < p.nb_subtrees; i++)
+    {
+      struct sSubtreeRBFS *parent = &p.subtrees[i];
+      struct sNode *node = &parent->node.node;
+      int blank = sliding_puzzle_cell_get (node->pos, 0, cell);
+      int last_move = puzzle->board->upper_nb_perms[blank];
+      for (int move = blank > 0 ? puzzle->board->upper_nb_perms[blank - 1] : 0; move < last_move; move++)
+      {
+        int initpos = puzzle->board->pos_perm[move];   // blank final position
+        int finalpos = blank;   // blank initial position
+        int m = initpos - finalpos;
+        if (m == -parent->node.move)
+          continue;
+
+        p.nodes[depth]++;
+        struct sSubtreeRBFS *child = &subtrees[nb_subtrees++];
+        child->node = parent->node;
+        child->node.move = m;
+        child->depth = depth + 1;
+        struct sNode *successor = &child->node.node;
+        CHECK_ALLOC (successor->grid = malloc (n * cell));
+        memcpy (successor->grid, node->grid, n * cell);
+        CHECK_ALLOC (successor->pos = malloc (n * cell));
+        memcpy (successor->pos, node->pos, n * cell);
+        CHECK_ALLOC (child->moves = malloc ((depth + 1) * sizeof (*child->moves)));
+        memcpy (child->moves, parent->moves, depth * sizeof (*child->moves));
+        child->moves[depth] = m;
+
+        // Move blank tile
+        int tile = sliding_puzzle_cell_get (node->grid, initpos, cell);
+        sliding_puzzle_cell_set (successor->grid, initpos, 0, cell);
+        sliding_puzzle_cell_set (successor->grid, finalpos, tile, cell);
+        sliding_puzzle_cell_set (successor->pos, 0, initpos, cell);
+        sliding_puzzle_cell_set (successor->pos, tile, finalpos, cell);
+        if (successor->cycle_state)
+          ACM_match (successor->cycle_state, puzzle->board->dir_perm[move]);
+
+        successor->d2sol = sliding_puzzle_distance_to_solutions (puzzle, successor->pos, cell, successor->d2patterns);
+        successor->solved = !successor->d2sol;
+        child->node.F = depth + 1 + successor->d2sol;
+        if (child->node.F < parent->node.F)     // path-max, as in sliding_puzzle_best_first_recursive_search
+          child->node.F = parent->node.F;
+
+        // Breadth-first: the first solution met is optimal.
+        if (successor->solved && p.best == INT_MAX)
+        {
+          p.best = depth + 1;
+          CHECK_ALLOC (p.solution = malloc (p.best * sizeof (*p.solution)));
+          memcpy (p.solution, child->moves, p.best * sizeof (*p.solution));
+        }
+        successor->solved = 0;
+      }
+    }
+
+    sliding_puzzle_subtrees_RBFS_free (p.subtrees, p.nb_subtrees);
+    p.subtrees = subtrees;
+    p.nb_subtrees = nb_subtrees;
+  }
+
+  if (p.best == INT_MAX)
+  {
+    PUZZLE_PRINT (puzzle, _("%1$i subtrees searched by %2$i threads... "), p.nb_subtrees, nb_threads);
+    for (; p.nb_started < nb_threads - 1; p.nb_started++)
+      if (pthread_create (&p.threads[p.nb_started], 0, sliding_puzzle_parallel_RBFS_worker, &p))
+        break;
+    // Cancellation point
+    sliding_puzzle_parallel_RBFS_worker (&p);
+    for (; p.nb_started > 0; p.nb_started--)
+      pthread_join (p.threads[p.nb_started - 1], 0);
+  }
+
+  length = p.best;
+  if (length < INT_MAX)
+  {
+    root->node.solved = 1;
+    int size = length > p.nodes_length ? length : p.nodes_length;
+    if (size > *pBufferLength)
+    {
+      CHECK_ALLOC (*pBuffer = realloc (*pBuffer, size * sizeof (**pBuffer)));
+      memset (*pBuffer + *pBufferLength, 0, (size - *pBufferLength) * sizeof (**pBuffer));
+      *pBufferLength = size;
+    }
+    for (int i = 0; i < length; i++)
+      (*pBuffer)[i].move = p.solution[i];
+    for (int i = 0; i < p.nodes_length; i++)
+      (*pBuffer)[i].nbGeneratedNodes = p.nodes[i];
+  }
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_parallel_RBFS_cleanup
+
+  return length;
+}
+
+/** Optimized solution searches algorithms - END **/
+
+/** Sliding puzzle toolbox - END **/
+
+/** User interface - BEGIN **/
+
+/** Helpers - BEGIN **/
+Puzzle
+sliding_puzzle_init4 (int width, int height, int *grid, FILE * f)
+{
+  // Check grid validity
+  // Search nodes hold tiles and positions on at most 16 bits (see NODE_CELL).
+  if (width <= 0 || height <= 0 || width * height < 2 || width * height > UINT16_MAX + 1)
+    return 0;
+
+  if (grid)
+    for (int i = 0; i < width * height; i++)
+    {
+      if (grid[i] < 0 || grid[i] >= width * height)
+        return 0;
+      else
+        for (int j = i + 1; j < width * height; j++)
+          if (grid[i] == grid[j])
+            return 0;
+    }
+
+  Puzzle puzzle = malloc (sizeof (*puzzle));
+  puzzle->width = width;
+  puzzle->height = height;
+  puzzle->orient = 0;
+  puzzle->cycle_database = 0;
+  puzzle->cycle_state = 0;
+  puzzle->heuristic_database = 0;
+  puzzle->distance_table = 0;
+  puzzle->perimeter_database = 0;
+  puzzle->d2perimeter = 0;
+  CHECK_ALLOC (puzzle->update = malloc (sizeof (*puzzle->update)));
+  atomic_init (&puzzle->update->heuristic_database, 0);
+  atomic_init (&puzzle->update->cycle_database, 0);
+  puzzle->stream = f;
+  puzzle->solution_shower = 0;
+  CHECK_ALLOC (puzzle->progress = calloc (1, sizeof (*puzzle->progress)));
+  puzzle->nb_threads = 1;
+  puzzle->stop = 0;
+
+  // Target solution for an odd grid :
+  // - ascending from 0 to (width * height - 1)
   // - the empty tile is on the upper left corner
   puzzle->grid_sol = malloc (width * height * sizeof (*puzzle->grid_sol));
   puzzle->pos_sol = malloc (width * height * sizeof (*puzzle->pos_sol));
   for (int i = 0; i < width * height; i++)
     puzzle->grid_sol[i] = i;    // Tile at position i
 
-  for (int i = 0; i < width * height; i++)
-    puzzle->pos_sol[puzzle->grid_sol[i]] = i;   // Position of tile i
+  for (int i = 0; i < width * height; i++)
+    puzzle->pos_sol[puzzle->grid_sol[i]] = i;   // Position of tile i
+
+  // Moves and distances, shared by the puzzles of the same shape.
+  puzzle->board = sliding_puzzle_board_get (width, height, puzzle->grid_sol);
+
+  // Initialisze puzzle->grid either from argument 'grid' or randmoly
+  puzzle->grid = malloc (width * height * sizeof (*puzzle->grid));
+  if (grid)                     // initialization tiles from 'grid'
+    memcpy (puzzle->grid, grid, width * height * sizeof (*puzzle->grid));
+  else                          // random initialization (Fisher-Yates shuffle)
+  {
+    for (int i = 0; i < width * height; i++)
+      puzzle->grid[i] = i;
+    for (int i = width * height - 1; i > 0; i--)
+    {
+      int j = alea (i);
+      int tile = puzzle->grid[i];
+      puzzle->grid[i] = puzzle->grid[j];
+      puzzle->grid[j] = tile;
+    }
+  }
+
+  // Compute grid parity
+  for (int i = 0; i < width * height; i++)
+    if (puzzle->grid[i] == 0)
+    {
+      puzzle->parity = i / puzzle->width;
+      break;
+    }
+
+  for (int pos1 = 0; pos1 < width * height; pos1++)
+    for (int pos2 = pos1 + 1; pos2 < width * height; pos2++)
+      if (puzzle->grid[pos1] != 0 && puzzle->grid[pos2] != 0
+          && puzzle->pos_sol[puzzle->grid[pos1]] > puzzle->pos_sol[puzzle->grid[pos2]])
+        puzzle->parity++;
+
+  PUZZLE_PRINT (puzzle, _("Puzzle (%s):\n"), puzzle->parity % 2 ? _("odd") : _("even"));
+
+  // Display puzzle->grid
+  for (int i = 0; i < height; i++)
+  {
+    for (int j = 0; j < width; j++)
+      if (puzzle->grid[i * height + j])
+        PUZZLE_PRINT (puzzle, " %2i", puzzle->grid[i * height + j]);
+      else
+        PUZZLE_PRINT (puzzle, "  .");
+    PUZZLE_PRINT (puzzle, "\n");
+  }
+
+  // Switch an odd parity grid to an even one applying a central symetry on position and tile number
+  if (puzzle->parity % 2)       // odd parity
+    for (int pos = 0; pos < (width * height + 1) / 2; pos++)    // the center of odd sized boards is its own image
+    {
+      int tmp = puzzle->grid[pos];
+      if (puzzle->grid[width * height - 1 - pos])
+        puzzle->grid[pos] = width * height - puzzle->grid[width * height - 1 - pos];
+      else
+        puzzle->grid[pos] = 0;
+      if (tmp)
+        puzzle->grid[width * height - 1 - pos] = width * height - tmp;
+      else
+        puzzle->grid[width * height - 1 - pos] = 0;
+    }
+
+  puzzle->pos = malloc (width * height * sizeof (*puzzle->pos));
+  for (int i = 0; i < width * height; i++)
+    puzzle->pos[puzzle->grid[i]] = i;   // Position of tiles
+
+  // Display target solution
+  PUZZLE_PRINT (puzzle, _("Target is:\n"));
+  for (int i = 0; i < height; i++)
+  {
+    for (int j = 0; j < width; j++)
+      if (puzzle->parity % 2 == 0)
+      {
+        if (puzzle->grid_sol[i * height + j])
+          PUZZLE_PRINT (puzzle, " %2i", puzzle->grid_sol[i * height + j]);
+        else
+          PUZZLE_PRINT (puzzle, "  .");
+      }
+      else
+      {
+        if (puzzle->grid_sol[width * height - 1 - i * height - j])
+          PUZZLE_PRINT (puzzle, " %2i", width * height - puzzle->grid_sol[width * height - 1 - i * height - j]);
+        else
+          PUZZLE_PRINT (puzzle, "  .");
+      }
+    PUZZLE_PRINT (puzzle, "\n");
+  }
+
+  ASSERT (puzzle->accessControl = rw_ac_create (), _("POSIX thread initialization error"));
+
+  PUZZLE_DEBUG (puzzle, _("Puzzle created.\n"));
+
+  puzzle->solved = 0;
+  puzzle->solution_length = 0;
+  puzzle->solution = 0;
+
+  return puzzle;
+}
+
+Puzzle
+sliding_puzzle_init2 (int width, int height)
+{
+  // Random grid, standard output stream.
+  return sliding_puzzle_init4 (width, height, 0, 0);
+}
+
+int
+sliding_puzzle_parity_get (Puzzle puzzle)
+{
+  return puzzle->parity % 2;
+}
+
+// Get 'puzzle' grid into 'grid'
+void
+sliding_puzzle_grid_get (Puzzle puzzle, int grid[])
+{
+  for (int pos = 0; pos < puzzle->width * puzzle->height; pos++)
+    if (!(puzzle->parity % 2))
+      grid[pos] = puzzle->grid[pos];
+    else if (puzzle->grid[puzzle->width * puzzle->height - 1 - pos])
+      grid[pos] = puzzle->width * puzzle->height - puzzle->grid[puzzle->width * puzzle->height - 1 - pos];
+    else
+      grid[pos] = 0;
+}
+
+// Thread safe
+void
+sliding_puzzle_random_seed (unsigned long long seed)
+{
+#ifdef RANDOMIZE_SEED
+  // The seed set here must not be overridden later by the lazy initialization from the clock.
+  pthread_once (&random_init_once, random_init);
+#endif
+  random_seed (seed);
+}
+
+// Get the optimal (shortest) sequence of moves to order the puzzle.
+void
+sliding_puzzle_solution_get (Puzzle puzzle, int solution[])
+{
+  for (int i = 0; i < puzzle->solution_length; i++)
+    solution[i] = puzzle->solution[i];
+}
+
+// Thread safe, lock-free: never blocks, even while a solver is running on 'puzzle'.
+int
+sliding_puzzle_progress_get (Puzzle puzzle, struct sPuzzleProgress *progress)
+{
+  if (!puzzle || !puzzle->progress || !progress)
+    return 0;
+
+  struct sSearchProgress *p = puzzle->progress;
+  progress->running = atomic_load_explicit (&p->running, memory_order_acquire);
+  progress->iteration = atomic_load_explicit (&p->iteration, memory_order_acquire);
+  progress->threshold = atomic_load_explicit (&p->threshold, memory_order_relaxed);
+  progress->f_bound = atomic_load_explicit (&p->f_bound, memory_order_relaxed);
+  progress->nodes = atomic_load_explicit (&p->nodes, memory_order_relaxed);
+
+  long long start = atomic_load_explicit (&p->start, memory_order_relaxed);
+  long long stop = progress->running ? 0 : atomic_load_explicit (&p->stop, memory_order_relaxed);
+  if (!start)
+    progress->elapsed = 0;
+  else
+    progress->elapsed = 1e-9 * ((stop ? stop : sliding_puzzle_clock_ns ()) - start);
+
+  return 1;
+}
+
+// Thread safe
+Puzzle_move_handler
+sliding_puzzle_move_handler_set (Puzzle puzzle, Puzzle_move_handler mh)
+{
+  Puzzle_move_handler ret = 0;
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+
+  ret = puzzle->solution_shower;
+  puzzle->solution_shower = mh;
+
+  sliding_puzzle_write_end (puzzle);
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+  return ret;
+}
+
+// Thread safe
+FILE *
+sliding_puzzle_stream_set (Puzzle puzzle, FILE * f)
+{
+  FILE *ret = 0;
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+
+  ret = puzzle->stream;
+  puzzle->stream = f;
+
+  sliding_puzzle_write_end (puzzle);
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+  return ret;
+}
+
+// Thread safe
+int
+sliding_puzzle_threads_set (Puzzle puzzle, int nb_threads)
+{
+  int ret = 0;
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+
+  ret = puzzle->nb_threads;
+  puzzle->nb_threads = nb_threads > 0 ? nb_threads : 1;
+
+  sliding_puzzle_write_end (puzzle);
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+  return ret;
+}
+
+/** Cycles database creation for puzzle - BEGIN **/
+
+// Thread cancelable, thread safe
+void
+sliding_puzzle_cycle_database_attach (Puzzle puzzle, int cycle_size)
+{
+  if (!puzzle || puzzle->width * puzzle->height == 0 || cycle_size <= 0)
+    return;
+
+  CycleDatabase volatile s = 0;
+  struct sRegistryEntry *entry = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+
+  // Cancellation point
+  // Reuse a cycle database already built for the size of the puzzle, if any.
+  s = sliding_puzzle_registry_lookup (CYCLE_DATABASE, puzzle->width, puzzle->height, cycle_size, 0, &entry);
+  if (s)
+    PUZZLE_PRINT (puzzle, _("Cycle bank (up to %i moves) found in registry.\n"), cycle_size);
+  else
+  {
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    PUZZLE_PRINT (puzzle, _("Search for cycles and record cycles in bank using IDA* (up to %i moves)...\n"),
+                  cycle_size);
+
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
+    // Cancellation point
+    // Create a cycle database for the size of the puzzle
+    s = sliding_puzzle_cycle_bank_create (puzzle->width, puzzle->height, cycle_size);   // allocation
+
+#if TRACE == 2
+    ACM_foreach_keyword (s->cycles, print_match);
+#endif
+
+    PUZZLE_PRINT (puzzle, _("%lu forbidden sequences of moves have been found.\n"), ACM_nb_keywords (s->cycles));
+    PUZZLE_PRINT (puzzle, _("Search for cycles and record cycles in bank using IDA* (up to %i moves)...DONE\n"),
+                  cycle_size);
+
+    sliding_puzzle_registry_store (entry, s);
+    pthread_cleanup_pop (0);    // sliding_puzzle_registry_abort
+  }
+
+  pthread_cleanup_push (cycle_database_cleanup, s);
+
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+
+  // The puzzle has already been previously attached.
+  if (sliding_puzzle_cycle_bank_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Cycle bank released.\n"));
+
+  puzzle->cycle_database = s;
+
+  PUZZLE_PRINT (puzzle, _("Cycle bank attached.\n"));
+  sliding_puzzle_write_end (puzzle);
+
+  pthread_cleanup_pop (0);      // state_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_cycle_database_share (Puzzle orig, Puzzle dest)
+{
+  if (!orig || !dest)
+    return 0;
+
+  if (orig == dest)
+    return 1;
+
+  // Check for compliant puzzles (same size)
+  if (orig->width != dest->width || orig->height != dest->height)
+    return 0;
+
+  int ret = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, dest);
+
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+  // Cancellation point
+  sliding_puzzle_read_begin (orig);
+  pthread_cleanup_push (sliding_puzzle_solve_read_clean, orig);
+
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+  // Cancellation point
+  sliding_puzzle_write_begin (dest);
+
+  // Sharing supersedes any database previously published to 'dest'.
+  sliding_puzzle_cycle_database_unref (atomic_exchange (&dest->update->cycle_database, 0));
+
+  if (orig->cycle_database == 0 || dest->cycle_database == 0 || orig->cycle_database != dest->cycle_database)
+  {
+    if (sliding_puzzle_cycle_bank_release (dest))
+      PUZZLE_PRINT (dest, _("Cycle bank released.\n"));
+
+    if (orig->cycle_database)
+    {
+      dest->cycle_database = sliding_puzzle_cycle_database_ref (orig->cycle_database);
+      ret = 1;
+      PUZZLE_PRINT (dest, _("Cycle bank shared with puzzle [%p].\n"), (void *) orig);
+    }
+  }
+  sliding_puzzle_write_end (dest);
+  pthread_cleanup_pop (1);      //sliding_puzzle_read_end (orig);
+  pthread_cleanup_pop (0);      //sliding_puzzle_cancellation_msg
+
+  return ret;
+}
+
+// Thread cancellable, thread safe
+// Does not wait for a solver running on 'dest': the cycle bank of 'orig' will be used by the next solver started on 'dest',
+// and the previous cycle bank of 'dest' will be released then, once no longer in use.
+int
+sliding_puzzle_cycle_database_publish (Puzzle orig, Puzzle dest)
+{
+  if (!orig || !dest)
+    return 0;
+
+  if (orig == dest)
+    return 1;
+
+  // Check for compliant puzzles (same size)
+  if (orig->width != dest->width || orig->height != dest->height)
+    return 0;
+
+  CycleDatabase cycle_database = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, dest);
+
+  // Cancellation point
+  sliding_puzzle_read_begin (orig);
+  // The reference held by 'orig' keeps the cycle bank alive while another one is taken.
+  cycle_database = sliding_puzzle_cycle_database_ref (orig->cycle_database);
+  sliding_puzzle_read_end (orig);
+
+  if (cycle_database)
+    sliding_puzzle_cycle_database_unref (atomic_exchange (&dest->update->cycle_database, cycle_database));
+
+  pthread_cleanup_pop (0);      //sliding_puzzle_cancellation_msg
+
+  return cycle_database ? 1 : 0;
+}
+
+/** Cycles database creation for puzzle - END **/
+
+/** Heuristic database creation for puzzle - BEGIN **/
+
+// Offset of the 'j'-th of the 'nb_tiles' tiles of a pattern at position 'q' in the index of the pattern, on puzzles
+// of 'size' cells.
+// If 'size' is a power of 2, the bits of the positions of the tiles are interleaved in the index (Morton order):
+// the low-order bits of the positions of all the tiles make the low-order bits of the index, so that the states reached
+// by a move of any tile of the pattern are close in the table, often on the same or a neighbouring cache line.
+// Otherwise, the positions are the digits of the index in base 'size' (the first tile is the most significant digit),
+// and only the moves of the last tile stay close in the table.
+static uint32_t
+sliding_puzzle_heuristic_offset (int size, int nb_tiles, int j, int q)
+{
+  uint32_t offset = 0;
+  if (size & (size - 1))
+  {
+    offset = q;
+    for (int k = j + 1; k < nb_tiles; k++)
+      offset *= size;
+  }
+  else
+    for (int b = 0; (1 << b) < size; b++)
+      offset |= (uint32_t) ((q >> b) & 1) << (b * nb_tiles + nb_tiles - 1 - j);
+  return offset;
+}
+
+// Indexes the tiles of the patterns of a database of puzzles of 'size' cells (see sliding_puzzle_heuristic_children_kernel).
+static void
+sliding_puzzle_heuristic_database_tiles (HeuristicDatabase database, int size)
+{
+  CHECK_ALLOC (database->tile_pattern = malloc (size * sizeof (*database->tile_pattern)));
+  CHECK_ALLOC (database->tile_offset = calloc (size * size, sizeof (*database->tile_offset)));
+  for (int tile = 0; tile < size; tile++)
+    database->tile_pattern[tile] = -1;
+  if (database->mirror_sol)
+  {
+    CHECK_ALLOC (database->mirror_tile_pattern = malloc (size * sizeof (*database->mirror_tile_pattern)));
+    CHECK_ALLOC (database->mirror_tile_offset = calloc (size * size, sizeof (*database->mirror_tile_offset)));
+    for (int tile = 0; tile < size; tile++)
+      database->mirror_tile_pattern[tile] = -1;
+  }
+
+  for (int i = 0; i < database->size_sol; i++)
+  {
+    struct sHeuristicData *db = &database->database_sol[i];
+    for (int j = 0; j < db->nb_tiles; j++)
+    {
+      database->tile_pattern[db->tiles[j]] = i;
+      for (int q = 0; q < size; q++)
+        database->tile_offset[db->tiles[j] * size + q] = sliding_puzzle_heuristic_offset (size, db->nb_tiles, j, q);
+      if (database->mirror_sol)
+      {
+        // The mirrored tile at position q is looked up as the tile of the pattern at the mirrored position.
+        int tile = database->mirror_sol[db->tiles[j]];
+        database->mirror_tile_pattern[tile] = i;
+        for (int q = 0; q < size; q++)
+          database->mirror_tile_offset[tile * size + q] =
+            sliding_puzzle_heuristic_offset (size, db->nb_tiles, j, database->mirror_pos[q]);
+      }
+    }
+  }
+}
+
+// Size of the distance table of a pattern of 'nb_tiles' tiles.
+static size_t
+sliding_puzzle_heuristic_table_size (int width, int height, int nb_tiles)
+{
+  size_t size = 1;
+  for (int j = 0; j < nb_tiles; j++)
+    size *= width * height;
+  return size;
+}
+
+// Creates a heuristic database for the size and target of the puzzle, without patterns yet.
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_new (Puzzle puzzle)
+{
+  HeuristicDatabase database = malloc (sizeof (*database));
+  database->mirror_pos = database->mirror_sol = 0;
+  database->tile_pattern = database->mirror_tile_pattern = 0;
+  database->tile_offset = database->mirror_tile_offset = 0;
+  database->database_sol = 0;
+  database->mapping = 0;
+  database->mapping_size = 0;
+  database->policy = SP_MEMORY_DEFAULT;
+  database->effective_policy = SP_MEMORY_DEFAULT;
+  database->replicas = 0;
+  database->nb_replicas = 0;
+  atomic_init (&database->nbUsers, 1);
+
+  // If the puzzle is a square then it can be mirrored along its diagonal.
+  if (puzzle->width == puzzle->height)
+  {
+    // mirror_pos[i] is the mirrored position of position i.
+    database->mirror_pos = malloc (puzzle->width * puzzle->height * sizeof (*database->mirror_pos));
+    for (int i = 0; i < puzzle->width * puzzle->height; i++)
+      database->mirror_pos[i] = puzzle->width * (i % puzzle->width) + (i / puzzle->width);
+
+    // If, moreover, the empty spot is on the diagonal, then the target solution can be mirrored along the diagonal.
+    if (puzzle->pos_sol[0] % (puzzle->width + 1) == 0)
+    {
+      database->mirror_sol = malloc (puzzle->width * puzzle->height * sizeof (*database->mirror_sol));
+      for (int i = 0; i < puzzle->width * puzzle->height; i++)
+        database->mirror_sol[puzzle->grid_sol[i]] = puzzle->grid_sol[database->mirror_pos[i]];
+    }
+  }
+
+  database->size_sol = 0;
+
+  return database;
+}
+
+// Adds a pattern of 'nb_tiles' tiles 'tiles' (allocated, owned by the database from now on) to a heuristic database,
+// in room allocated by the caller.
+static void
+sliding_puzzle_heuristic_database_pattern_add (Puzzle puzzle, HeuristicDatabase database, int *tiles, int nb_tiles)
+{
+  if (database->mirror_sol)
+  {
+    PUZZLE_PRINT (puzzle, _(", (mirrored along first diagonal)"));
+    for (int t = 0; t < nb_tiles; t++)
+      if (puzzle->parity % 2)
+        PUZZLE_PRINT (puzzle, " %2i", puzzle->width * puzzle->height - database->mirror_sol[tiles[t]]);
+      else
+        PUZZLE_PRINT (puzzle, " %2i", database->mirror_sol[tiles[t]]);
+  }
+
+  database->database_sol[database->size_sol].database = 0;
+  database->database_sol[database->size_sol].tiles = tiles;
+  database->database_sol[database->size_sol].nb_tiles = nb_tiles;
+  database->size_sol++;
+}
+
+// Creates a heuristic database for the size and target of the puzzle, without its distance tables yet:
+// the tiles of the target are split into blocks (patterns) of 'pattern_size' adjacent tiles.
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_patterns (Puzzle puzzle, int pattern_size)
+{
+  HeuristicDatabase database = sliding_puzzle_heuristic_database_new (puzzle);
+
+  // The number of blocks of adjacent 'pattern_size' tiles in the ouzzle
+  int nb_pattern = (puzzle->width * puzzle->height - 2 + pattern_size) / pattern_size;
+
+  database->database_sol = malloc (nb_pattern * sizeof (*database->database_sol));
+
+  // Create 'nb_pattern' blocks of 'pattern_size' adjacent tiles
+  PUZZLE_PRINT (puzzle, _("Patterns for target:\n"));
+  int p_start, p;
+  p_start = 0;
+  for (int l = 0; l < nb_pattern; l++)
+  {
+    int *tiles = 0;
+    int nb_tiles = 0;
+
+    // Create a block of 'pattern_size' adjacent tiles
+    PUZZLE_PRINT (puzzle, _("Tiles"));
+    for (p = p_start; nb_tiles < pattern_size && p < puzzle->width * puzzle->height; p++)
+    {
+      int pos = p / puzzle->width;
+      if (pos % 2)
+        pos = (pos + 1) * puzzle->width - p % puzzle->width - 1;
+      else
+        pos = p;
+      if (pattern_size % 2 == 0)
+        pos = puzzle->width * puzzle->height - 1 - pos;
+      if (puzzle->grid_sol[pos])        // not the blank
+      {
+        nb_tiles++;
+        tiles = realloc (tiles, nb_tiles * sizeof (*tiles));
+        tiles[nb_tiles - 1] = puzzle->grid_sol[pos];
+        if (puzzle->parity % 2)
+          PUZZLE_PRINT (puzzle, " %2i", puzzle->width * puzzle->height - tiles[nb_tiles - 1]);
+        else
+          PUZZLE_PRINT (puzzle, " %2i", tiles[nb_tiles - 1]);
+      }
+    }
+
+    if (nb_tiles)
+      sliding_puzzle_heuristic_database_pattern_add (puzzle, database, tiles, nb_tiles);
+
+    PUZZLE_PRINT (puzzle, "\n");
+
+    if (p == puzzle->width * puzzle->height)
+      break;
+    else
+      p_start = p;
+  }
+
+  sliding_puzzle_heuristic_database_tiles (database, puzzle->width * puzzle->height);
+
+  return database;
+}
+
+// Index of the entry of base 'size' order 'ii' (see sliding_puzzle_heuristic_table_reorder), 'size' being 2^'bits'.
+static uint32_t
+sliding_puzzle_heuristic_table_index (HeuristicDatabase database, const struct sHeuristicData *db, int size, int bits,
+                                      size_t ii)
+{
+  // Digits of 'ii' in base 'size': the positions of the tiles, the last tile first.
+  uint32_t index = 0;
+  for (int j = db->nb_tiles - 1; j >= 0; j--, ii >>= bits)
+    index += database->tile_offset[db->tiles[j] * size + (ii & (size - 1))];
+  return index;
+}
+
+// Reorders the distance table of pattern 'db', computed in base 'size' order
+// (see sliding_puzzle_heuristic_database_create), following the offsets of its tiles (see sliding_puzzle_heuristic_offset),
+// 'size' being a power of 2.
+// The table is reordered in place, following the cycles of the permutation: the only extra memory is one bit per entry
+// (entries already in place), an eighth of the table.
+static void
+sliding_puzzle_heuristic_table_reorder (HeuristicDatabase database, struct sHeuristicData *db, int size)
+{
+  size_t table_size = 1;
+  for (int j = 0; j < db->nb_tiles; j++)
+    table_size *= size;
+  int bits = 0;
+  while ((1 << bits) < size)
+    bits++;
+  uint8_t *placed;
+  CHECK_ALLOC (placed = calloc (table_size / CHAR_BIT + 1, sizeof (*placed)));
+
+  for (size_t start = 0; start < table_size; start++)
+  {
+    if (placed[start / CHAR_BIT] & (1 << (start % CHAR_BIT)))
+      continue;
+    // Moves the entry of 'start' to its index, the entry found there to its own index, and so on back to 'start'.
+    int8_t value = db->database[start];
+    size_t ii = start;
+    do
+    {
+      ii = sliding_puzzle_heuristic_table_index (database, db, size, bits, ii);
+      int8_t next = db->database[ii];
+      db->database[ii] = value;
+      value = next;
+      placed[ii / CHAR_BIT] |= 1 << (ii % CHAR_BIT);
+    }
+    while (ii != start);
+  }
+
+  free (placed);
+}
+
+// Thread cancellable
+// Computes the distance tables of the patterns of a heuristic database, either in 'memory' if not null
+// (tables are then laid out contiguously, in the order of patterns), or in allocated memory otherwise.
+static void
+sliding_puzzle_heuristic_database_fill (Puzzle puzzle, HeuristicDatabase database, int8_t * memory)
+{
+  for (int l = 0; l < database->size_sol; l++)
+  {
+    struct sHeuristicData *db = &database->database_sol[l];
+    int *positions = malloc (db->nb_tiles * sizeof (*positions));
+    for (int t = 0; t < db->nb_tiles; t++)
+      positions[t] = puzzle->pos_sol[db->tiles[t]];
+
+    // For each block, calculate distances of any positions of the tiles of this block to the target solution.
+    db->database = sliding_puzzle_heuristic_database_create (puzzle->width, puzzle->height, db->nb_tiles, positions,
+                                                            memory);
+    if (!((puzzle->width * puzzle->height) & (puzzle->width * puzzle->height - 1)))
+      sliding_puzzle_heuristic_table_reorder (database, db, puzzle->width * puzzle->height);
+    if (memory)
+      memory += sliding_puzzle_heuristic_table_size (puzzle->width, puzzle->height, db->nb_tiles);
+    free (positions);
+
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
+    // Cancellation point
+    pthread_testcancel ();
+  }
+}
+
+// Registry key of a heuristic database: its pattern size and the memory policy of its tables.
+#define HEURISTIC_REGISTRY_SIZE(pattern_size, policy) ((pattern_size) + ((policy) << 8))
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20)       // default size of huge pages on x86-64 and arm64
+#define NUMA_MPOL_BIND 2        // see set_mempolicy(2)
+
+// Number of NUMA nodes of the machine, 1 if unknown.
+static int
+sliding_puzzle_numa_nodes (void)
+{
+  int first = 0, last = 0;
+  FILE *f = fopen ("/sys/devices/system/node/possible", "r");   // "0" or "0-3"
+  if (f)
+  {
+    if (fscanf (f, "%i-%i", &first, &last) < 2)
+      last = first;
+    fclose (f);
+  }
+  return last + 1;
+}
+
+// Whether transparent huge pages are enabled (in /sys/kernel/mm/transparent_hugepage/enabled, "[always] madvise never"
+// or "always [madvise] never"): madvise(MADV_HUGEPAGE) succeeds even if they are "[never]".
+static int
+sliding_puzzle_transparent_huge_pages (void)
+{
+  char enabled[64] = "";
+  FILE *f = fopen ("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (f)
+  {
+    if (!fgets (enabled, sizeof (enabled), f))
+      *enabled = 0;
+    fclose (f);
+  }
+  return strstr (enabled, "[always]") || strstr (enabled, "[madvise]");
+}
+
+// NUMA node of the CPU the calling thread runs on, 0 if unknown.
+static int
+sliding_puzzle_numa_node (void)
+{
+  unsigned int cpu, node = 0;
+#ifdef SYS_getcpu
+  if (syscall (SYS_getcpu, &cpu, &node, 0))
+    node = 0;
+#endif
+  return node;
+}
+
+// Allocates 'size' bytes of memory for distance tables following 'policy' (see enum eHeuristicMemoryPolicy),
+// on NUMA node 'node' if not negative. Returns the memory, and the size of the mapping in '*mapping_size', or 0.
+// The policy granted is returned in '*effective_policy': reserved huge pages fall back to transparent ones, and these
+// to regular pages. SP_MEMORY_NUMA_REPLICAS is granted if the memory is bound to 'node' (no node has it otherwise).
+static void *
+sliding_puzzle_heuristic_memory_map (size_t size, int policy, int node, size_t *mapping_size, int *effective_policy)
+{
+  void *memory = MAP_FAILED;
+  size_t length = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  *effective_policy = SP_MEMORY_DEFAULT;
+
+#ifdef MAP_HUGETLB
+  if (policy & SP_MEMORY_HUGE_PAGES_RESERVED)
+    memory = mmap (0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (memory != MAP_FAILED)
+    *effective_policy = SP_MEMORY_HUGE_PAGES_RESERVED;
+#endif
+  if (memory == MAP_FAILED && (policy & (SP_MEMORY_HUGE_PAGES | SP_MEMORY_HUGE_PAGES_RESERVED)))
+  {
+    // Aligned on a huge page, so that the whole mapping can be backed by transparent huge pages.
+    char *m = mmap (0, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m != MAP_FAILED)
+    {
+      size_t head = (HUGE_PAGE_SIZE - (uintptr_t) m % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+      if (head)
+        munmap (m, head);
+      munmap (m + head + length, HUGE_PAGE_SIZE - head);
+      memory = m + head;
+#ifdef MADV_HUGEPAGE
+      // Without transparent huge pages (kernel built without them, or disabled), the aligned mapping is kept,
+      // on regular pages.
+      if (!madvise (memory, length, MADV_HUGEPAGE) && sliding_puzzle_transparent_huge_pages ())
+        *effective_policy = SP_MEMORY_HUGE_PAGES;
+#endif
+    }
+  }
+  if (memory == MAP_FAILED)
+    memory = mmap (0, length = size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    return 0;
+
+#ifdef SYS_mbind
+  // Pages are placed when they are first written: the tables are not filled yet.
+  if (node >= 0 && node < (int) (sizeof (unsigned long) * CHAR_BIT) - 1)
+  {
+    unsigned long nodemask = 1UL << node;
+    if (!syscall (SYS_mbind, memory, length, NUMA_MPOL_BIND, &nodemask, sizeof (nodemask) * CHAR_BIT, 0))
+      *effective_policy |= SP_MEMORY_NUMA_REPLICAS;
+  }
+#endif
+
+  *mapping_size = length;
+  return memory;
+}
+
+// Thread cancellable
+// Copies the distance tables of 'database', held in its mapping, on each of the other NUMA nodes of the machine.
+// Stops at the first copy that cannot be bound to its node: returns 1 if every node has its copy, 0 otherwise.
+// The huge pages of the database are those granted to all its copies.
+static int
+sliding_puzzle_heuristic_database_replicate (HeuristicDatabase database, int nb_nodes)
+{
+  CHECK_ALLOC (database->replicas = calloc (nb_nodes, sizeof (*database->replicas)));
+  database->replicas[0] = database;
+  database->nb_replicas = 1;
+  for (int node = 1; node < nb_nodes; node++)
+  {
+    HeuristicDatabase replica;
+    CHECK_ALLOC (replica = malloc (sizeof (*replica)));
+    *replica = *database;
+    replica->replicas = 0;
+    replica->nb_replicas = 0;
+    int effective_policy;
+    CHECK_ALLOC (replica->mapping =
+                 sliding_puzzle_heuristic_memory_map (database->mapping_size, database->policy, node,
+                                                      &replica->mapping_size, &effective_policy));
+    if (!(effective_policy & SP_MEMORY_NUMA_REPLICAS))
+    {
+      munmap (replica->mapping, replica->mapping_size);
+      free (replica);
+      return 0;
+    }
+    database->effective_policy &= effective_policy;
+    CHECK_ALLOC (replica->database_sol = malloc (database->size_sol * sizeof (*replica->database_sol)));
+    memcpy (replica->mapping, database->mapping, database->mapping_size);
+    for (int l = 0; l < database->size_sol; l++)
+    {
+      replica->database_sol[l] = database->database_sol[l];
+      replica->database_sol[l].database =
+        (int8_t *) replica->mapping + (database->database_sol[l].database - (int8_t *) database->mapping);
+    }
+    database->replicas[database->nb_replicas++] = replica;
+
+    // Cancellation point
+    pthread_testcancel ();
+  }
+
+  return 1;
+}
+
+// Database to be looked up by the calling thread: the replica of its NUMA node, if any.
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_local (HeuristicDatabase database)
+{
+  if (!database || database->nb_replicas < 2)
+    return database;
+  int node = sliding_puzzle_numa_node ();
+  return node < database->nb_replicas ? database->replicas[node] : database;
+}
+
+// Thread cancellable
+// Computes the distance tables of the patterns of a heuristic database, allocated following 'policy'.
+// The database is destroyed on cancellation.
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_tables (Puzzle puzzle, HeuristicDatabase database, int policy)
+{
+  pthread_cleanup_push (sliding_puzzle_heuristic_database_cleanup, database);
+
+  int8_t *memory = 0;
+  int nb_nodes = policy & SP_MEMORY_NUMA_REPLICAS ? sliding_puzzle_numa_nodes () : 1;
+  if (policy != SP_MEMORY_DEFAULT)
+  {
+    // All the tables in one mapping, one after the other.
+    size_t size = 0;
+    for (int l = 0; l < database->size_sol; l++)
+      size += sliding_puzzle_heuristic_table_size (puzzle->width, puzzle->height, database->database_sol[l].nb_tiles);
+    database->policy = policy;
+    CHECK_ALLOC (memory = database->mapping =
+                 sliding_puzzle_heuristic_memory_map (size, policy, nb_nodes > 1 ? 0 : -1, &database->mapping_size,
+                                                      &database->effective_policy));
+    if ((policy & SP_MEMORY_HUGE_PAGES_RESERVED) && !(database->effective_policy & SP_MEMORY_HUGE_PAGES_RESERVED))
+      PUZZLE_PRINT (puzzle, _("No reserved huge pages free for the heuristic database.\n"));
+    if ((policy & (SP_MEMORY_HUGE_PAGES | SP_MEMORY_HUGE_PAGES_RESERVED))
+        && !(database->effective_policy & (SP_MEMORY_HUGE_PAGES | SP_MEMORY_HUGE_PAGES_RESERVED)))
+      PUZZLE_PRINT (puzzle, _("No huge pages for the heuristic database: using regular pages.\n"));
+    if (nb_nodes > 1 && !(database->effective_policy & SP_MEMORY_NUMA_REPLICAS))
+    {
+      PUZZLE_PRINT (puzzle, _("Heuristic database not bound to NUMA node 0: not copied on the other nodes.\n"));
+      nb_nodes = 1;
+    }
+    // Replicas are only granted once they are all made.
+    database->effective_policy &= ~SP_MEMORY_NUMA_REPLICAS;
+  }
+
+  // Cancellation point
+  sliding_puzzle_heuristic_database_fill (puzzle, database, memory);
+
+  if (nb_nodes > 1)
+  {
+    PUZZLE_PRINT (puzzle, _("Copy heuristic database on %i NUMA nodes...\n"), nb_nodes);
+    // Cancellation point
+    if (sliding_puzzle_heuristic_database_replicate (database, nb_nodes))
+      database->effective_policy |= SP_MEMORY_NUMA_REPLICAS;
+    else
+      PUZZLE_PRINT (puzzle, _("Heuristic database copied on %i NUMA nodes only.\n"), database->nb_replicas);
+  }
+
+  pthread_cleanup_pop (0);      // database_cleanup
+
+  return database;
+}
+
+// Thread cancellable
+// Creates a heuristic database for the size and target of the puzzle
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_build (Puzzle puzzle, int pattern_size, int restricted, int policy)
+{
+  PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (pattern max size is %1$i%2$s)...\n"),
+                pattern_size, restricted ? _(", restricted by hardware capabilities") : "");
+
+  // Cancellation point
+  HeuristicDatabase database =
+    sliding_puzzle_heuristic_database_tables (puzzle, sliding_puzzle_heuristic_database_patterns (puzzle, pattern_size),
+                                              policy);
+
+  PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (pattern max size is %i)...DONE\n"),
+                pattern_size);
+
+  return database;
+}
+
+// Maximum pattern size allowed by the hardware capabilities (size of the distance tables, 32-bit indexes)
+// Not inlined in its callers, where its loop counters would live across the setjmp of pthread_cleanup_push.
+static __attribute__ ((noinline)) int
+sliding_puzzle_heuristic_pattern_size_max (Puzzle puzzle)
+{
+  int size_max = 0;
+  for (uintmax_t max = 1;
+       max <= UINTMAX_MAX / puzzle->width / puzzle->height && max * puzzle->width * puzzle->height - 1 <= UINT32_MAX
+       && max <= SIZE_MAX / puzzle->width / puzzle->height; size_max++)
+    max *= puzzle->width * puzzle->height;
+  return size_max;
+}
+
+// Thread cancellable, thread safe
+void
+sliding_puzzle_heuristic_database_attach (Puzzle puzzle, int pattern_size)
+{
+  sliding_puzzle_heuristic_database_attach_policy (puzzle, pattern_size, SP_MEMORY_DEFAULT);
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_heuristic_database_attach_policy (Puzzle puzzle, int pattern_size, int policy)
+{
+  if (!puzzle || puzzle->width * puzzle->height == 0 || pattern_size <= 0
+      || (policy & ~(SP_MEMORY_HUGE_PAGES | SP_MEMORY_HUGE_PAGES_RESERVED | SP_MEMORY_NUMA_REPLICAS)))
+    return -1;
+
+  int size_max = sliding_puzzle_heuristic_pattern_size_max (puzzle);
+  if (pattern_size > size_max)
+    pattern_size = size_max;
+  int largest = pattern_size == size_max;
+
+  HeuristicDatabase volatile database = 0;
+  struct sRegistryEntry *entry = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+
+  // Cancellation point
+  // Reuse a heuristic database already built for the size and target of the puzzle, if any.
+  database =
+    sliding_puzzle_registry_lookup (HEURISTIC_DATABASE, puzzle->width, puzzle->height,
+                                    HEURISTIC_REGISTRY_SIZE (pattern_size, policy), puzzle->grid_sol, &entry);
+  if (database)
+    PUZZLE_PRINT (puzzle, _("Heuristic database (pattern max size is %i) found in registry.\n"), pattern_size);
+  else
+  {
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    // Cancellation point
+    database = sliding_puzzle_heuristic_database_build (puzzle, pattern_size, largest, policy);
+    sliding_puzzle_registry_store (entry, database);
+    pthread_cleanup_pop (0);    // sliding_puzzle_registry_abort
+  }
+
+  pthread_cleanup_push (sliding_puzzle_heuristic_database_cleanup, database);
+
+#ifdef TEST_CANCELLATION_POINT
+  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+    pthread_cancel (*thread_cancellation_point_test);
+#endif
+
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+  if (sliding_puzzle_heuristic_database_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
+  puzzle->heuristic_database = database;
+  PUZZLE_PRINT (puzzle, _("Heuristic database attached.\n"));
+  sliding_puzzle_write_end (puzzle);
+
+  pthread_cleanup_pop (0);      // database_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return database->effective_policy;
+}
+
+// Memory of the distance tables of the heuristic database of pattern size 'pattern_size'
+// (see sliding_puzzle_heuristic_database_patterns: blocks of 'pattern_size' tiles, the last one possibly smaller).
+static size_t
+sliding_puzzle_heuristic_database_memory (Puzzle puzzle, int pattern_size)
+{
+  size_t memory = 0;
+  for (int nb_tiles = puzzle->width * puzzle->height - 1; nb_tiles > 0; nb_tiles -= pattern_size)
+    memory +=
+      sliding_puzzle_heuristic_table_size (puzzle->width, puzzle->height,
+                                           nb_tiles < pattern_size ? nb_tiles : pattern_size);
+  return memory;
+}
+
+// State of the selection, in memory: it lives across the cleanup scopes of sliding_puzzle_heuristic_database_attach_budget.
+struct sHeuristicSelection
+{
+  int size_max;                 // largest pattern size of the puzzle
+  HeuristicDatabase best;       // best candidate so far, if it is the last one evaluated (0 otherwise)
+  int best_size;
+  size_t best_memory;
+  double best_value;
+  int *samples;
+};
+
+static void
+sliding_puzzle_heuristic_selection_cleanup (void *arg)
+{
+  struct sHeuristicSelection *selection = arg;
+  sliding_puzzle_heuristic_database_unref (selection->best);
+  free (selection->samples);
+}
+
+// Thread cancellable
+// Heuristic database of pattern size 'pattern_size', from the registry or built (then not registered).
+static HeuristicDatabase
+sliding_puzzle_heuristic_database_candidate (Puzzle puzzle, int pattern_size, int largest)
+{
+  struct sRegistryEntry *entry = 0;
+  // Cancellation point
+  HeuristicDatabase volatile database =
+    sliding_puzzle_registry_lookup (HEURISTIC_DATABASE, puzzle->width, puzzle->height,
+                                    HEURISTIC_REGISTRY_SIZE (pattern_size, SP_MEMORY_DEFAULT), puzzle->grid_sol, &entry);
+  if (!database)
+  {
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    // Cancellation point
+    database = sliding_puzzle_heuristic_database_build (puzzle, pattern_size, largest, SP_MEMORY_DEFAULT);
+    pthread_cleanup_pop (1);    // sliding_puzzle_registry_abort
+  }
+  return database;
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_heuristic_database_attach_budget (Puzzle puzzle, size_t memory_budget, int nb_samples, size_t *memory)
+{
+  if (!puzzle || puzzle->width * puzzle->height == 0 || nb_samples <= 0)
+    return 0;
+
+  int size = puzzle->width * puzzle->height;
+  struct sHeuristicSelection selection = {.size_max = sliding_puzzle_heuristic_pattern_size_max (puzzle),.best_value = -1 };
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+  pthread_cleanup_push (sliding_puzzle_heuristic_selection_cleanup, &selection);
+
+  // Positions of the tiles of random grids (Fisher-Yates shuffle). The distances of the patterns are defined
+  // for any positions of their tiles, solvable or not.
+  CHECK_ALLOC (selection.samples = malloc (nb_samples * size * sizeof (*selection.samples)));
+  for (int s = 0; s < nb_samples; s++)
+  {
+    int *pos = selection.samples + s * size;
+    for (int i = 0; i < size; i++)
+      pos[i] = i;
+    for (int i = size - 1; i > 0; i--)
+    {
+      int j = alea (i);
+      int tile = pos[i];
+      pos[i] = pos[j];
+      pos[j] = tile;
+    }
+  }
+
+  // Candidates are the partitions of the snake of the target into blocks of one size (see
+  // sliding_puzzle_heuristic_database_patterns, e.g. 8-7, 6-6-3, 5-5-5 on 4x4) that fit in the budget.
+  // The one with the highest mean distance on the samples is chosen: the larger the mean heuristic,
+  // the fewer nodes to expand. One database at most is in memory at a time, within the budget: the best one so far
+  // is dropped before the next candidate is built, and built again at the end if it was not the last one.
+  for (int pattern_size = 1; pattern_size <= selection.size_max && pattern_size < size; pattern_size++)
+  {
+    size_t candidate_memory = sliding_puzzle_heuristic_database_memory (puzzle, pattern_size);
+    if (candidate_memory > memory_budget)
+      continue;
+
+    sliding_puzzle_heuristic_database_unref (selection.best);
+    selection.best = 0;
+    // Cancellation point
+    // Candidates are not registered, only the chosen one is (below).
+    HeuristicDatabase database =
+      sliding_puzzle_heuristic_database_candidate (puzzle, pattern_size, pattern_size == selection.size_max);
+
+    double value = 0;
+    int d2patterns[2];
+    for (int s = 0; s < nb_samples; s++)
+      value += sliding_puzzle_heuristic_distances (database, selection.samples + s * size, size, sizeof (int),
+                                                   d2patterns);
+    value /= nb_samples;
+    PUZZLE_PRINT (puzzle, _("Heuristic database (pattern max size is %1$i): %2$zu bytes, mean distance %3$.2f.\n"),
+                  pattern_size, candidate_memory, value);
+
+    // Ties go to the smaller database.
+    if (value > selection.best_value)
+    {
+      selection.best = database;
+      selection.best_value = value;
+      selection.best_size = pattern_size;
+      selection.best_memory = candidate_memory;
+    }
+    else
+      sliding_puzzle_heuristic_database_unref (database);
+  }
+
+  if (selection.best_size)
+  {
+    if (!selection.best)
+      // Cancellation point
+      selection.best = sliding_puzzle_heuristic_database_candidate (puzzle, selection.best_size,
+                                                                    selection.best_size == selection.size_max);
+
+    struct sRegistryEntry *entry = 0;
+    // Cancellation point
+    HeuristicDatabase database =
+      sliding_puzzle_registry_lookup (HEURISTIC_DATABASE, puzzle->width, puzzle->height,
+                                      HEURISTIC_REGISTRY_SIZE (selection.best_size, SP_MEMORY_DEFAULT),
+                                      puzzle->grid_sol, &entry);
+    if (database)
+      sliding_puzzle_heuristic_database_unref (database);
+    else
+      sliding_puzzle_registry_store (entry, selection.best);
+
+    PUZZLE_PRINT (puzzle, _("Heuristic database chosen within %zu bytes: patterns"), memory_budget);
+    for (int i = 0; i < selection.best->size_sol; i++)
+      PUZZLE_PRINT (puzzle, i ? "-%i" : " %i", selection.best->database_sol[i].nb_tiles);
+    PUZZLE_PRINT (puzzle, _(", %zu bytes.\n"), selection.best_memory);
+
+    // Cancellation point
+    // Found in the registry.
+    sliding_puzzle_heuristic_database_attach (puzzle, selection.best_size);
+    if (memory)
+      *memory = selection.best_memory;
+  }
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_heuristic_selection_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return selection.best_size;
+}
+
+// Thread safe
+int
+sliding_puzzle_heuristic_database_groups (Puzzle puzzle, int group_sizes[], int tiles[])
+{
+  if (!puzzle)
+    return 0;
+
+  int volatile nb_groups = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+  // Cancellation point
+  sliding_puzzle_read_begin (puzzle);
+  pthread_cleanup_push (sliding_puzzle_solve_read_clean, puzzle);
+
+  HeuristicDatabase database = puzzle->heuristic_database;
+  if (database)
+  {
+    nb_groups = database->size_sol;
+    for (int g = 0, t = 0; g < database->size_sol; t += database->database_sol[g].nb_tiles, g++)
+    {
+      if (group_sizes)
+        group_sizes[g] = database->database_sol[g].nb_tiles;
+      if (tiles)
+        memcpy (tiles + t, database->database_sol[g].tiles, database->database_sol[g].nb_tiles * sizeof (*tiles));
+    }
+  }
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_read_end (puzzle)
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return nb_groups;
+}
+
+// Group of each tile (from 1), 0 for the blank, or 0 if the groups are not disjoint or do not cover all the tiles
+// but the blank (see sliding_puzzle_heuristic_database_attach_groups).
+static int *
+sliding_puzzle_heuristic_database_groups_check (Puzzle puzzle, int nb_groups, const int group_sizes[], const int tiles[])
+{
+  int size = puzzle->width * puzzle->height;
+  int size_max = sliding_puzzle_heuristic_pattern_size_max (puzzle);
+
+  int *groups;
+  CHECK_ALLOC (groups = calloc (size, sizeof (*groups)));
+  int nb_tiles = 0;
+  int valid = 1;
+  for (int g = 0; g < nb_groups && valid; g++)
+  {
+    if (group_sizes[g] <= 0 || group_sizes[g] > size_max || nb_tiles + group_sizes[g] >= size)
+      valid = 0;
+    for (int t = 0; t < group_sizes[g] && valid; t++, nb_tiles++)
+      if (tiles[nb_tiles] <= 0 || tiles[nb_tiles] >= size || groups[tiles[nb_tiles]])
+        valid = 0;
+      else
+        groups[tiles[nb_tiles]] = g + 1;
+  }
+  if (!valid || nb_tiles != size - 1)
+  {
+    free (groups);
+    return 0;
+  }
+
+  return groups;
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_heuristic_database_attach_groups (Puzzle puzzle, int nb_groups, const int group_sizes[],
+                                                 const int tiles[])
+{
+  if (!puzzle || puzzle->width * puzzle->height == 0 || nb_groups <= 0 || !group_sizes || !tiles)
+    return 0;
+
+  int size = puzzle->width * puzzle->height;
+  int *groups = sliding_puzzle_heuristic_database_groups_check (puzzle, nb_groups, group_sizes, tiles);
+  if (!groups)
+    return 0;
+
+  HeuristicDatabase volatile database = 0;
+  struct sRegistryEntry *entry = 0;
 
-  // Loop on authorized moves.
-  // Initialize valid permutations : valid moves, considering grid borders
-  // upper_nb_perms[i] is is the number of possible moves for tiles for which position is between 0 and position i.
-  // pos_perm, with index from 0 to nb_perms[i] (excluded) is the list of those authorized moves.
-  puzzle->pos_perm = malloc ((4 * width * height - 2 * (width + height)) * sizeof (*puzzle->pos_perm));
-  puzzle->nb_perms = 0;
-  puzzle->upper_nb_perms = malloc (width * height * sizeof (*puzzle->upper_nb_perms));
-  for (int i = 0; i < width * height; i++)
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+
+  // Cancellation point
+  // Reuse a heuristic database already built for the same groups, if any: the target is the same for all
+  // the puzzles of a size, and the groups of the tiles stand for it in the key.
+  // The registry keeps its own copy of the key, so the groups are released right after the lookup.
+  pthread_cleanup_push (free, groups);
+  database =
+    sliding_puzzle_registry_lookup (HEURISTIC_DATABASE, puzzle->width, puzzle->height,
+                                    HEURISTIC_REGISTRY_SIZE (0, SP_MEMORY_DEFAULT), groups, &entry);
+  pthread_cleanup_pop (1);      // free
+  if (database)
+    PUZZLE_PRINT (puzzle, _("Heuristic database (user-defined patterns) found in registry.\n"));
+  else
   {
-    if (i - width >= 0)         // not the upper border
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (user-defined patterns)...\n"));
+
+    database = sliding_puzzle_heuristic_database_new (puzzle);
+    CHECK_ALLOC (database->database_sol = malloc (nb_groups * sizeof (*database->database_sol)));
+    PUZZLE_PRINT (puzzle, _("Patterns for target:\n"));
+    for (int g = 0, t = 0; g < nb_groups; t += group_sizes[g], g++)
     {
-      puzzle->pos_perm[puzzle->nb_perms] = i - width;
-      puzzle->nb_perms++;
+      int *pattern;
+      CHECK_ALLOC (pattern = malloc (group_sizes[g] * sizeof (*pattern)));
+      memcpy (pattern, tiles + t, group_sizes[g] * sizeof (*pattern));
+      PUZZLE_PRINT (puzzle, _("Tiles"));
+      for (int j = 0; j < group_sizes[g]; j++)
+        if (puzzle->parity % 2)
+          PUZZLE_PRINT (puzzle, " %2i", size - pattern[j]);
+        else
+          PUZZLE_PRINT (puzzle, " %2i", pattern[j]);
+      sliding_puzzle_heuristic_database_pattern_add (puzzle, database, pattern, group_sizes[g]);
+      PUZZLE_PRINT (puzzle, "\n");
     }
-    if (i + width < width * height)     // not the lower border
+    sliding_puzzle_heuristic_database_tiles (database, size);
+
+    // Cancellation point
+    database = sliding_puzzle_heuristic_database_tables (puzzle, database, SP_MEMORY_DEFAULT);
+    PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (user-defined patterns)...DONE\n"));
+    sliding_puzzle_registry_store (entry, database);
+    pthread_cleanup_pop (0);    // sliding_puzzle_registry_abort
+  }
+
+  pthread_cleanup_push (sliding_puzzle_heuristic_database_cleanup, database);
+
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+  if (sliding_puzzle_heuristic_database_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
+  puzzle->heuristic_database = database;
+  PUZZLE_PRINT (puzzle, _("Heuristic database attached.\n"));
+  sliding_puzzle_write_end (puzzle);
+
+  pthread_cleanup_pop (0);      // database_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return 1;
+}
+
+/** Heuristic database shared between processes - BEGIN **/
+// The distance tables are computed once, by the first process that creates the POSIX shared memory object,
+// directly in the shared memory. The other processes map the same object read-only and wait for it to be ready.
+// Only the distance tables are shared: the description of the patterns is rebuilt locally (it is cheap and deterministic).
+// The builder holds an exclusive lock (see flock(2)) on the object from its creation until the tables are ready:
+// the lock is released by the system if the builder dies, and the waiting processes then give up.
+#define SHARED_DATABASE_MAGIC 0x15504443u
+#define SHARED_DATABASE_POLLING_PERIOD 10000000L        // nanoseconds
+#define SHARED_DATABASE_SIZING_TIMEOUT 10000000000LL    // nanoseconds, for the builder to lock and size the object
+
+struct sSharedDatabaseHeader
+{
+  uint32_t magic;
+  atomic_int ready;             // 0: being built, 1: ready, -1: build aborted
+  int width, height, pattern_size;
+  size_t size;                  // Size of the whole shared memory object
+  size_t offset;                // Offset of the first distance table
+  int grid_sol[];               // Target of the puzzle
+};
+
+struct sSharedDatabaseBuild
+{
+  struct sSharedDatabaseHeader *header;
+  const char *name;
+};
+
+static void
+sliding_puzzle_shared_database_abort (void *arg)
+{
+  struct sSharedDatabaseBuild *build = arg;
+  // Processes waiting for the tables give up, and the name is freed for a later attempt.
+  atomic_store (&build->header->ready, -1);
+  shm_unlink (build->name);
+}
+
+static void
+sliding_puzzle_fd_close (void *arg)
+{
+  close (*(int *) arg);
+}
+
+// Whether the builder of the shared memory object 'fd' still holds its lock.
+static int
+sliding_puzzle_shared_database_builder_alive (int fd)
+{
+  if (flock (fd, LOCK_SH | LOCK_NB))
+    return errno == EWOULDBLOCK;
+  flock (fd, LOCK_UN);
+  return 0;
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_heuristic_database_attach_shared (Puzzle puzzle, int pattern_size, const char *name)
+{
+  if (!puzzle || puzzle->width * puzzle->height == 0 || pattern_size <= 0 || !name)
+    return 0;
+
+  int size_max = sliding_puzzle_heuristic_pattern_size_max (puzzle);
+  if (pattern_size > size_max)
+    pattern_size = size_max;
+
+  int volatile ret = 0;
+  struct sSharedDatabaseHeader *volatile header = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+
+  HeuristicDatabase database = sliding_puzzle_heuristic_database_patterns (puzzle, pattern_size);
+  pthread_cleanup_push (sliding_puzzle_heuristic_database_cleanup, database);
+
+  // Layout: header, target, then the distance tables one after the other (aligned on a cache line).
+  size_t offset = sizeof (*header) + puzzle->width * puzzle->height * sizeof (*header->grid_sol);
+  offset = (offset + 63) / 64 * 64;
+  size_t size = offset;
+  for (int l = 0; l < database->size_sol; l++)
+    size += sliding_puzzle_heuristic_table_size (puzzle->width, puzzle->height, database->database_sol[l].nb_tiles);
+
+  int fd = -1;
+  pthread_cleanup_push (sliding_puzzle_fd_close, &fd);
+
+  if ((fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, 0644)) >= 0)
+  {
+    // This process builds the tables, under lock until they are ready (the lock is released when 'fd' is closed).
+    if (flock (fd, LOCK_EX) == 0 && ftruncate (fd, size) == 0
+        && (header = mmap (0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) != MAP_FAILED)
     {
-      puzzle->pos_perm[puzzle->nb_perms] = i + width;
-      puzzle->nb_perms++;
+      database->mapping = header;
+      database->mapping_size = size;
+
+      header->magic = SHARED_DATABASE_MAGIC;
+      header->width = puzzle->width;
+      header->height = puzzle->height;
+      header->pattern_size = pattern_size;
+      header->size = size;
+      header->offset = offset;
+      memcpy (header->grid_sol, puzzle->grid_sol, puzzle->width * puzzle->height * sizeof (*header->grid_sol));
+
+      PUZZLE_PRINT (puzzle, _("Create shared heuristic database '%1$s' (pattern max size is %2$i%3$s)...\n"), name,
+                    pattern_size, pattern_size == size_max ? _(", restricted by hardware capabilities") : "");
+
+      struct sSharedDatabaseBuild build = {.header = header,.name = name };
+      pthread_cleanup_push (sliding_puzzle_shared_database_abort, &build);
+      // Cancellation point
+      sliding_puzzle_heuristic_database_fill (puzzle, database, (int8_t *) header + offset);
+      pthread_cleanup_pop (0);  // sliding_puzzle_shared_database_abort
+
+      atomic_store (&header->ready, 1);
+      ret = 1;
+      PUZZLE_PRINT (puzzle, _("Create shared heuristic database '%1$s' (pattern max size is %2$i)...DONE\n"), name,
+                    pattern_size);
     }
-    if (i - 1 >= 0 && (i - 1) / width == i / width)     // not the leftmost border
+    else
     {
-      puzzle->pos_perm[puzzle->nb_perms] = i - 1;
-      puzzle->nb_perms++;
+      header = 0;
+      shm_unlink (name);
     }
-    if (i + 1 < width * height && (i + 1) / width == i / width) // not the rightmost border
+  }
+  else if (errno == EEXIST && (fd = shm_open (name, O_RDONLY, 0)) >= 0)
+  {
+    // Another process builds (or has built) the tables: wait for the object to be sized, then for the tables to be ready,
+    // as long as the builder is alive.
+    struct stat st;
+    struct timespec period = {.tv_sec = 0,.tv_nsec = SHARED_DATABASE_POLLING_PERIOD };
+    int sized;
+    long long waited = 0;
+    // Cancellation point
+    while ((sized = fstat (fd, &st) == 0) && st.st_size == 0)
     {
-      puzzle->pos_perm[puzzle->nb_perms] = i + 1;
-      puzzle->nb_perms++;
+      if ((waited += SHARED_DATABASE_POLLING_PERIOD) > SHARED_DATABASE_SIZING_TIMEOUT)
+      {
+        sized = 0;
+        break;
+      }
+      nanosleep (&period, 0);
     }
-    puzzle->upper_nb_perms[i] = puzzle->nb_perms;
-  }
 
-  // Initialisze puzzle->grid either from argument 'grid' or randmoly
-  puzzle->grid = malloc (width * height * sizeof (*puzzle->grid));
-  if (grid)                     // initialization tiles from 'grid'
-    memcpy (puzzle->grid, grid, width * height * sizeof (*puzzle->grid));
-  else                          // random initialization
-  {
-    for (int i = 0; i < width * height; i++)
-      while (1)
+    if (sized && (size_t) st.st_size == size
+        && (header = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED)
+    {
+      database->mapping = header;
+      database->mapping_size = size;
+
+      // Cancellation point
+      while (!atomic_load (&header->ready) && sliding_puzzle_shared_database_builder_alive (fd))
+        nanosleep (&period, 0);
+
+      if (atomic_load (&header->ready) > 0 && header->magic == SHARED_DATABASE_MAGIC
+          && header->width == puzzle->width && header->height == puzzle->height
+          && header->pattern_size == pattern_size && header->size == size && header->offset == offset
+          && !memcmp (header->grid_sol, puzzle->grid_sol, puzzle->width * puzzle->height * sizeof (*header->grid_sol)))
       {
-        int tile = alea (width * height - 1);
-        for (int j = 0; j < i; j++)
-          if (puzzle->grid[j] == tile)
-          {
-            tile = -1;
-            break;
-          }
-        if (tile != -1)
+        int8_t *table = (int8_t *) header + offset;
+        for (int l = 0; l < database->size_sol; l++)
         {
-          puzzle->grid[i] = tile;
-          break;
+          database->database_sol[l].database = table;
+          table += sliding_puzzle_heuristic_table_size (puzzle->width, puzzle->height, database->database_sol[l].nb_tiles);
         }
+        ret = 1;
+        PUZZLE_PRINT (puzzle, _("Shared heuristic database '%1$s' (pattern max size is %2$i) mapped.\n"), name,
+                      pattern_size);
       }
-  }
-
-  // Compute grid parity
-  for (int i = 0; i < width * height; i++)
-    if (puzzle->grid[i] == 0)
-    {
-      puzzle->parity = i / puzzle->width;
-      break;
     }
+    else
+      header = 0;
+  }
 
-  for (int pos1 = 0; pos1 < width * height; pos1++)
-    for (int pos2 = pos1 + 1; pos2 < width * height; pos2++)
-      if (puzzle->grid[pos1] != 0 && puzzle->grid[pos2] != 0
-          && puzzle->pos_sol[puzzle->grid[pos1]] > puzzle->pos_sol[puzzle->grid[pos2]])
-        puzzle->parity++;
+  if (!ret)
+    PUZZLE_DEBUG (puzzle, _("Shared heuristic database '%1$s' could not be attached.\n"), name);
 
-  PUZZLE_PRINT (puzzle, _("Puzzle (%s):\n"), puzzle->parity % 2 ? _("odd") : _("even"));
+  pthread_cleanup_pop (1);      // sliding_puzzle_fd_close (the mapping remains valid)
 
-  // Display puzzle->grid
-  for (int i = 0; i < height; i++)
+  if (ret)
   {
-    for (int j = 0; j < width; j++)
-      if (puzzle->grid[i * height + j])
-        PUZZLE_PRINT (puzzle, " %2i", puzzle->grid[i * height + j]);
-      else
-        PUZZLE_PRINT (puzzle, "  .");
-    PUZZLE_PRINT (puzzle, "\n");
-  }
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
 
-  // Switch an odd parity grid to an even one applying a central symetry on position and tile number
-  if (puzzle->parity % 2)       // odd parity
-    for (int pos = 0; pos < width * height / 2; pos++)
-    {
-      int tmp = puzzle->grid[pos];
-      if (puzzle->grid[width * height - 1 - pos])
-        puzzle->grid[pos] = width * height - puzzle->grid[width * height - 1 - pos];
-      else
-        puzzle->grid[pos] = 0;
-      if (tmp)
-        puzzle->grid[width * height - 1 - pos] = width * height - tmp;
-      else
-        puzzle->grid[width * height - 1 - pos] = 0;
-    }
+    // Cancellation point
+    sliding_puzzle_write_begin (puzzle);
+    if (sliding_puzzle_heuristic_database_release (puzzle))
+      PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
+    puzzle->heuristic_database = database;
+    PUZZLE_PRINT (puzzle, _("Heuristic database attached.\n"));
+    sliding_puzzle_write_end (puzzle);
+  }
 
-  puzzle->pos = malloc (width * height * sizeof (*puzzle->pos));
-  for (int i = 0; i < width * height; i++)
-    puzzle->pos[puzzle->grid[i]] = i;   // Position of tiles
+  pthread_cleanup_pop (!ret);   // database_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
 
-  // Display target solution
-  PUZZLE_PRINT (puzzle, _("Target is:\n"));
-  for (int i = 0; i < height; i++)
-  {
-    for (int j = 0; j < width; j++)
-      if (puzzle->parity % 2 == 0)
-      {
-        if (puzzle->grid_sol[i * height + j])
-          PUZZLE_PRINT (puzzle, " %2i", puzzle->grid_sol[i * height + j]);
-        else
-          PUZZLE_PRINT (puzzle, "  .");
-      }
-      else
-      {
-        if (puzzle->grid_sol[width * height - 1 - i * height - j])
-          PUZZLE_PRINT (puzzle, " %2i", width * height - puzzle->grid_sol[width * height - 1 - i * height - j]);
-        else
-          PUZZLE_PRINT (puzzle, "  .");
-      }
-    PUZZLE_PRINT (puzzle, "\n");
-  }
+  return ret;
+}
 
-  ASSERT (puzzle->accessControl = rw_ac_create (), _("POSIX thread initialization error"));
+int
+sliding_puzzle_heuristic_database_unlink (const char *name)
+{
+  return name && shm_unlink (name) == 0;
+}
 
-  PUZZLE_DEBUG (puzzle, _("Puzzle created.\n"));
+/** Heuristic database shared between processes - END **/
 
-  puzzle->solved = 0;
-  puzzle->solution_length = 0;
-  puzzle->solution = 0;
+/** Complete distance tables - BEGIN **/
+static uint64_t
+sliding_puzzle_factorial (int n)
+{
+  uint64_t f = 1;
+  for (int i = 2; i <= n; i++)
+    f *= i;
+  return f;
+}
 
-  return puzzle;
+// Rank of the permutation 'grid' of 'n' tiles in lexicographic order (the target grid has rank 0).
+static uint64_t
+sliding_puzzle_permutation_rank (const int *grid, int n)
+{
+  uint64_t rank = 0;
+  unsigned int unused = (1u << n) - 1;
+  for (int i = 0; i < n; i++)
+  {
+    rank = rank * (n - i) + __builtin_popcount (unused & ((1u << grid[i]) - 1));
+    unused &= ~(1u << grid[i]);
+  }
+  return rank;
 }
 
-Puzzle
-sliding_puzzle_init2 (int width, int height)
+static void
+sliding_puzzle_permutation_unrank (uint64_t rank, int n, int *grid, const uint64_t * factorials)
 {
-  // Random grid, standard output stream.
-  return sliding_puzzle_init4 (width, height, 0, 0);
+  unsigned int unused = (1u << n) - 1;
+  for (int i = 0; i < n; i++)
+  {
+    int digit = rank / factorials[n - 1 - i];
+    rank %= factorials[n - 1 - i];
+    unsigned int bits = unused;
+    for (; digit; digit--)
+      bits &= bits - 1;
+    grid[i] = __builtin_ctz (bits);
+    unused &= ~(1u << grid[i]);
+  }
 }
 
-int
-sliding_puzzle_parity_get (Puzzle puzzle)
+static int
+sliding_puzzle_distance_get (const uint8_t * distances, uint64_t rank)
 {
-  return puzzle->parity % 2;
+  return (distances[rank / 4] >> (2 * (rank % 4))) & 3;
 }
 
-// Get 'puzzle' grid into 'grid'
-void
-sliding_puzzle_grid_get (Puzzle puzzle, int grid[])
+static void
+sliding_puzzle_distance_set (uint8_t * distances, uint64_t rank, int distance)
 {
-  for (int pos = 0; pos < puzzle->width * puzzle->height; pos++)
-    if (!(puzzle->parity % 2))
-      grid[pos] = puzzle->grid[pos];
-    else if (puzzle->grid[puzzle->width * puzzle->height - 1 - pos])
-      grid[pos] = puzzle->width * puzzle->height - puzzle->grid[puzzle->width * puzzle->height - 1 - pos];
-    else
-      grid[pos] = 0;
+  distances[rank / 4] = (distances[rank / 4] & ~(3 << (2 * (rank % 4)))) | (distance << (2 * (rank % 4)));
 }
 
-// Get the optimal (shortest) sequence of moves to order the puzzle.
-void
-sliding_puzzle_solution_get (Puzzle puzzle, int solution[])
+struct sDistanceTableBuild
 {
-  for (int i = 0; i < puzzle->solution_length; i++)
-    solution[i] = puzzle->solution[i];
+  DistanceTable table;
+  uint64_t *frontier, *next;
+};
+
+static void
+sliding_puzzle_distance_table_build_cleanup (void *arg)
+{
+  struct sDistanceTableBuild *b = arg;
+  sliding_puzzle_distance_table_unref (b->table);
+  free (b->frontier);
+  free (b->next);
 }
 
-// Thread safe
-Puzzle_move_handler
-sliding_puzzle_move_handler_set (Puzzle puzzle, Puzzle_move_handler mh)
+// Thread cancellable
+// Builds the distance table by breadth-first search from the target, level by level.
+// The states of the current and next levels are marked in bitmaps, so that memory stays at 2 bits + 2 bits per state.
+static DistanceTable
+sliding_puzzle_distance_table_build (Puzzle puzzle)
 {
-  Puzzle_move_handler ret = 0;
-  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+  int n = puzzle->width * puzzle->height;
+  uint64_t factorials[DISTANCE_TABLE_MAX_TILES + 1];
+  for (int i = 0; i <= n; i++)
+    factorials[i] = sliding_puzzle_factorial (i);
+
+  DistanceTable table = 0;
+  struct sDistanceTableBuild b;
+  CHECK_ALLOC (b.table = malloc (sizeof (*b.table)));
+  b.table->width = puzzle->width;
+  b.table->height = puzzle->height;
+  b.table->nb_states = factorials[n];
+  atomic_init (&b.table->nbUsers, 1);
+  b.table->distances = malloc ((b.table->nb_states + 3) / 4);
+  b.frontier = calloc ((b.table->nb_states + 63) / 64, sizeof (*b.frontier));
+  b.next = calloc ((b.table->nb_states + 63) / 64, sizeof (*b.next));
+  pthread_cleanup_push (sliding_puzzle_distance_table_build_cleanup, &b);
+  CHECK_ALLOC (b.table->distances && b.frontier && b.next);
+
+  PUZZLE_PRINT (puzzle, _("Create distance table using retrograde breadth-first search (%" PRIu64 " states)...\n"),
+                b.table->nb_states);
+
+  memset (b.table->distances, 0xFF, (b.table->nb_states + 3) / 4);
+  sliding_puzzle_distance_set (b.table->distances, 0, 0);
+  b.frontier[0] = 1;
+
+  int grid[DISTANCE_TABLE_MAX_TILES];
+  uint64_t nb_reached = 1;
+  for (int distance = 0;; distance++)
+  {
+    uint64_t nb_next = 0;
+    for (uint64_t w = 0; w < (b.table->nb_states + 63) / 64; w++)
+      for (uint64_t bits = b.frontier[w]; bits; bits &= bits - 1)
+      {
+        sliding_puzzle_permutation_unrank (64 * w + __builtin_ctzll (bits), n, grid, factorials);
+        int blank = 0;
+        while (grid[blank])
+          blank++;
+        // Loop on authorized moves of the empty position (see sliding_puzzle_depth_first_recursive_search).
+        for (int move = blank > 0 ? puzzle->board->upper_nb_perms[blank - 1] : 0; move < puzzle->board->upper_nb_perms[blank]; move++)
+        {
+          int pos = puzzle->board->pos_perm[move];
+          grid[blank] = grid[pos];
+          grid[pos] = 0;
+          uint64_t rank = sliding_puzzle_permutation_rank (grid, n);
+          if (sliding_puzzle_distance_get (b.table->distances, rank) == DISTANCE_UNKNOWN)
+          {
+            sliding_puzzle_distance_set (b.table->distances, rank, (distance + 1) % 3);
+            b.next[rank / 64] |= UINT64_C (1) << (rank % 64);
+            nb_next++;
+          }
+          grid[pos] = grid[blank];
+          grid[blank] = 0;
+        }
+      }
+
+    if (!nb_next)
+    {
+      PUZZLE_PRINT (puzzle, _("%1$" PRIu64 " states reached, at most %2$i moves away from the target.\n"), nb_reached,
+                    distance);
+      break;
+    }
+    nb_reached += nb_next;
+
+    uint64_t *frontier = b.frontier;
+    b.frontier = b.next;
+    b.next = frontier;
+    memset (b.next, 0, (b.table->nb_states + 63) / 64 * sizeof (*b.next));
+
 #ifdef TEST_CANCELLATION_POINT
-  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-    pthread_cancel (*thread_cancellation_point_test);
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
 #endif
-  // Cancellation point
-  sliding_puzzle_write_begin (puzzle);
+    // Cancellation point
+    pthread_testcancel ();
+  }
+
+  PUZZLE_PRINT (puzzle, _("Create distance table using retrograde breadth-first search...DONE\n"));
+
+  table = b.table;
+  b.table = 0;
+  pthread_cleanup_pop (1);      // sliding_puzzle_distance_table_build_cleanup (bitmaps only)
+
+  return table;
+}
+
+#define DISTANCE_TABLE_MAGIC "SPDT"
+
+static DistanceTable
+sliding_puzzle_distance_table_load (Puzzle puzzle, const char *filename)
+{
+  FILE *f = fopen (filename, "rb");
+  if (!f)
+    return 0;
+
+  DistanceTable table = 0;
+  char magic[4];
+  int32_t size[2];
+  if (fread (magic, sizeof (magic), 1, f) == 1 && !memcmp (magic, DISTANCE_TABLE_MAGIC, sizeof (magic))
+      && fread (size, sizeof (size), 1, f) == 1 && size[0] == puzzle->width && size[1] == puzzle->height)
+  {
+    CHECK_ALLOC (table = malloc (sizeof (*table)));
+    table->width = puzzle->width;
+    table->height = puzzle->height;
+    table->nb_states = sliding_puzzle_factorial (puzzle->width * puzzle->height);
+    atomic_init (&table->nbUsers, 1);
+    CHECK_ALLOC (table->distances = malloc ((table->nb_states + 3) / 4));
+    if (fread (table->distances, (table->nb_states + 3) / 4, 1, f) != 1)
+    {
+      sliding_puzzle_distance_table_unref (table);
+      table = 0;
+    }
+  }
+  fclose (f);
 
-  ret = puzzle->solution_shower;
-  puzzle->solution_shower = mh;
+  if (table)
+    PUZZLE_PRINT (puzzle, _("Distance table loaded from '%s'.\n"), filename);
 
-  sliding_puzzle_write_end (puzzle);
-  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
-  return ret;
+  return table;
 }
 
-// Thread safe
-FILE *
-sliding_puzzle_stream_set (Puzzle puzzle, FILE * f)
+static void
+sliding_puzzle_distance_table_save (Puzzle puzzle, DistanceTable table, const char *filename)
 {
-  FILE *ret = 0;
-  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
-#ifdef TEST_CANCELLATION_POINT
-  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-    pthread_cancel (*thread_cancellation_point_test);
-#endif
-  // Cancellation point
-  sliding_puzzle_write_begin (puzzle);
-
-  ret = puzzle->stream;
-  puzzle->stream = f;
+  FILE *f = fopen (filename, "wb");
+  if (!f)
+    return;
 
-  sliding_puzzle_write_end (puzzle);
-  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
-  return ret;
+  int32_t size[2] = { table->width, table->height };
+  if (fwrite (DISTANCE_TABLE_MAGIC, 4, 1, f) == 1 && fwrite (size, sizeof (size), 1, f) == 1
+      && fwrite (table->distances, (table->nb_states + 3) / 4, 1, f) == 1 && !fclose (f))
+    PUZZLE_PRINT (puzzle, _("Distance table saved to '%s'.\n"), filename);
+  else
+  {
+    fclose (f);
+    remove (filename);
+  }
 }
 
-/** Cycles database creation for puzzle - BEGIN **/
-
-// Thread cancelable, thread safe
-void
-sliding_puzzle_cycle_database_attach (Puzzle puzzle, int cycle_size)
+// Thread cancellable, thread safe
+int
+sliding_puzzle_distance_table_attach (Puzzle puzzle, const char *filename)
 {
-  if (!puzzle || puzzle->width * puzzle->height == 0 || cycle_size <= 0)
-    return;
+  if (!puzzle || puzzle->width * puzzle->height > DISTANCE_TABLE_MAX_TILES)
+    return 0;
+
+  DistanceTable volatile table = 0;
+  struct sRegistryEntry *entry = 0;
 
   pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
-  PUZZLE_PRINT (puzzle, _("Search for cycles and record cycles in bank using IDA* (up to %i moves)...\n"), cycle_size);
 
-#ifdef TEST_CANCELLATION_POINT
-  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-    pthread_cancel (*thread_cancellation_point_test);
-#endif
   // Cancellation point
-  // Create a cycle database for the size of the puzzle
-  CycleDatabase s = sliding_puzzle_cycle_bank_create (puzzle->width, puzzle->height, cycle_size);       // allocation
-
-  pthread_cleanup_push (cycle_database_cleanup, s);
-
-#if TRACE == 2
-  ACM_foreach_keyword (s->cycles, print_match);
-#endif
+  // Reuse a distance table already built for the size of the puzzle, if any.
+  table = sliding_puzzle_registry_lookup (DISTANCE_TABLE, puzzle->width, puzzle->height, 0, 0, &entry);
+  if (table)
+    PUZZLE_PRINT (puzzle, _("Distance table found in registry.\n"));
+  else
+  {
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    if (!filename || !(table = sliding_puzzle_distance_table_load (puzzle, filename)))
+    {
+      // Cancellation point
+      table = sliding_puzzle_distance_table_build (puzzle);
+      if (filename)
+        sliding_puzzle_distance_table_save (puzzle, table, filename);
+    }
+    sliding_puzzle_registry_store (entry, table);
+    pthread_cleanup_pop (0);    // sliding_puzzle_registry_abort
+  }
 
-  PUZZLE_PRINT (puzzle, _("%lu forbidden sequences of moves have been found.\n"), ACM_nb_keywords (s->cycles));
-  PUZZLE_PRINT (puzzle, _("Search for cycles and record cycles in bank using IDA* (up to %i moves)...DONE\n"),
-                cycle_size);
+  pthread_cleanup_push (sliding_puzzle_distance_table_cleanup, table);
 
 #ifdef TEST_CANCELLATION_POINT
   if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
@@ -1878,24 +5206,21 @@ sliding_puzzle_cycle_database_attach (Puzzle puzzle, int cycle_size)
 
   // Cancellation point
   sliding_puzzle_write_begin (puzzle);
-
-  // The puzzle has already been previously attached.
-  if (sliding_puzzle_cycle_bank_release (puzzle))
-    PUZZLE_PRINT (puzzle, _("Cycle bank released.\n"));
-
-  puzzle->cycle_database = s;
-  puzzle->cycle_database->nbUsers = 1;
-
-  PUZZLE_PRINT (puzzle, _("Cycle bank attached.\n"));
+  if (sliding_puzzle_distance_table_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Distance table released.\n"));
+  puzzle->distance_table = table;
+  PUZZLE_PRINT (puzzle, _("Distance table attached.\n"));
   sliding_puzzle_write_end (puzzle);
 
-  pthread_cleanup_pop (0);      // state_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_distance_table_cleanup
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return 1;
 }
 
 // Thread cancellable, thread safe
 int
-sliding_puzzle_cycle_database_share (Puzzle orig, Puzzle dest)
+sliding_puzzle_distance_table_share (Puzzle orig, Puzzle dest)
 {
   if (!orig || !dest)
     return 0;
@@ -1907,38 +5232,27 @@ sliding_puzzle_cycle_database_share (Puzzle orig, Puzzle dest)
   if (orig->width != dest->width || orig->height != dest->height)
     return 0;
 
-  int ret = 0;
+  int volatile ret = 0;
 
   pthread_cleanup_push (sliding_puzzle_cancellation_msg, dest);
 
-#ifdef TEST_CANCELLATION_POINT
-  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-    pthread_cancel (*thread_cancellation_point_test);
-#endif
   // Cancellation point
   sliding_puzzle_read_begin (orig);
   pthread_cleanup_push (sliding_puzzle_solve_read_clean, orig);
 
-#ifdef TEST_CANCELLATION_POINT
-  if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
-      && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
-    pthread_cancel (*thread_cancellation_point_test);
-#endif
   // Cancellation point
   sliding_puzzle_write_begin (dest);
 
-  if (orig->cycle_database == 0 || dest->cycle_database == 0 || orig->cycle_database != dest->cycle_database)
+  if (orig->distance_table != dest->distance_table)
   {
-    if (sliding_puzzle_cycle_bank_release (dest))
-      PUZZLE_PRINT (dest, _("Cycle bank released.\n"));
+    if (sliding_puzzle_distance_table_release (dest))
+      PUZZLE_PRINT (dest, _("Distance table released.\n"));
 
-    if (orig->cycle_database)
+    dest->distance_table = sliding_puzzle_distance_table_ref (orig->distance_table);
+    if (dest->distance_table)
     {
-      dest->cycle_database = orig->cycle_database;
-      dest->cycle_database->nbUsers++;
       ret = 1;
-      PUZZLE_PRINT (dest, _("Cycle bank shared with puzzle [%p].\n"), (void *) orig);
+      PUZZLE_PRINT (dest, _("Distance table shared with puzzle [%p].\n"), (void *) orig);
     }
   }
   sliding_puzzle_write_end (dest);
@@ -1948,127 +5262,203 @@ sliding_puzzle_cycle_database_share (Puzzle orig, Puzzle dest)
   return ret;
 }
 
-/** Cycles database creation for puzzle - END **/
-
-/** Heuristic database creation for puzzle - BEGIN **/
-
-// Thread cancellable, thread safe
-void
-sliding_puzzle_heuristic_database_attach (Puzzle puzzle, int pattern_size)
+// Reads the optimal solution in the distance table, one move at a time: the moves are returned in '*moves' (to be freed).
+// Returns the length of the solution, or -1 if the puzzle can not reach the target.
+static int
+sliding_puzzle_distance_table_descend (Puzzle puzzle, int **moves)
 {
-  if (!puzzle || puzzle->width * puzzle->height == 0 || pattern_size <= 0)
-    return;
+  int n = puzzle->width * puzzle->height;
+  const uint8_t *distances = puzzle->distance_table->distances;
+  int grid[DISTANCE_TABLE_MAX_TILES];
+  memcpy (grid, puzzle->grid, n * sizeof (*grid));
+  int blank = puzzle->pos[0];
+
+  uint64_t rank = sliding_puzzle_permutation_rank (grid, n);
+  int distance = sliding_puzzle_distance_get (distances, rank);
+  if (distance == DISTANCE_UNKNOWN)
+    return -1;
 
-  int size_max = 0;
-  for (uintmax_t max = 1;
-       max <= UINTMAX_MAX / puzzle->width / puzzle->height && max * puzzle->width * puzzle->height - 1 <= UINT32_MAX
-       && max <= SIZE_MAX / puzzle->width / puzzle->height; size_max++)
-    max *= puzzle->width * puzzle->height;
+  int length = 0;
+  *moves = 0;
+  while (rank)
+  {
+    int found = 0;
+    int last_move = puzzle->board->upper_nb_perms[blank];
+    for (int move = blank > 0 ? puzzle->board->upper_nb_perms[blank - 1] : 0; !found && move < last_move; move++)
+    {
+      int pos = puzzle->board->pos_perm[move];
+      grid[blank] = grid[pos];
+      grid[pos] = 0;
+      uint64_t next = sliding_puzzle_permutation_rank (grid, n);
+      if (sliding_puzzle_distance_get (distances, next) == (distance + 2) % 3)
+      {
+        CHECK_ALLOC (*moves = realloc (*moves, (length + 1) * sizeof (**moves)));
+        (*moves)[length++] = pos - blank;
+        blank = pos;
+        rank = next;
+        distance = (distance + 2) % 3;
+        found = 1;
+      }
+      else
+      {
+        grid[pos] = grid[blank];
+        grid[blank] = 0;
+      }
+    }
+    ASSERT (found, _("Inconsistent distance table"));
+  }
 
-  if (pattern_size > size_max)
-    pattern_size = size_max;
+  return length;
+}
 
-  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
-  PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (pattern max size is %1$i%2$s)...\n"),
-                pattern_size, pattern_size == size_max ? _(", restricted by hardware capabilities") : "");
+/** Complete distance tables - END **/
 
-  // Create a heuristic database for the size of the puzzle
-  HeuristicDatabase database = malloc (sizeof (*database));
-  database->mirror_pos = database->mirror_sol = 0;
-  database->database_sol = 0;
-  database->nbUsers = 0;
+/** Perimeter database - BEGIN **/
+struct sPerimeterBuild
+{
+  PerimeterDatabase database;
+  uint64_t (*frontier)[2], (*next)[2];
+};
 
-  pthread_cleanup_push (sliding_puzzle_heuristic_database_cleanup, database);
+static void
+sliding_puzzle_perimeter_build_cleanup (void *arg)
+{
+  struct sPerimeterBuild *b = arg;
+  sliding_puzzle_perimeter_database_unref (b->database);
+  free (b->frontier);
+  free (b->next);
+}
 
-  // If the puzzle is a square then it can be mirrored along its diagonal.
-  if (puzzle->width == puzzle->height)
-  {
-    // mirror_pos[i] is the mirrored position of position i.
-    database->mirror_pos = malloc (puzzle->width * puzzle->height * sizeof (*database->mirror_pos));
-    for (int i = 0; i < puzzle->width * puzzle->height; i++)
-      database->mirror_pos[i] = puzzle->width * (i % puzzle->width) + (i / puzzle->width);
+// Resizes the hash table of the perimeter to 'capacity' slots (a power of 2), keeping its content.
+static void
+sliding_puzzle_perimeter_rehash (PerimeterDatabase pdb, uint64_t capacity)
+{
+  uint64_t (*keys)[2] = pdb->keys;
+  int8_t *distances = pdb->distances;
+  uint64_t old_capacity = pdb->capacity;
 
-    // If, moreover, the empty spot is on the diagonal, then the target solution can be mirrored along the diagonal.
-    if (puzzle->pos_sol[0] % (puzzle->width + 1) == 0)
+  pdb->capacity = capacity;
+  CHECK_ALLOC (pdb->keys = malloc (capacity * sizeof (*pdb->keys)));
+  CHECK_ALLOC (pdb->distances = malloc (capacity * sizeof (*pdb->distances)));
+  memset (pdb->keys, 0xFF, capacity * sizeof (*pdb->keys));
+
+  for (uint64_t i = 0; i < old_capacity; i++)
+    if (keys[i][0] != PERIMETER_EMPTY)
     {
-      database->mirror_sol = malloc (puzzle->width * puzzle->height * sizeof (*database->mirror_sol));
-      for (int i = 0; i < puzzle->width * puzzle->height; i++)
-        database->mirror_sol[puzzle->grid_sol[i]] = puzzle->grid_sol[database->mirror_pos[i]];
+      uint64_t slot = sliding_puzzle_perimeter_slot (pdb, keys[i]);
+      pdb->keys[slot][0] = keys[i][0];
+      pdb->keys[slot][1] = keys[i][1];
+      pdb->distances[slot] = distances[i];
     }
-  }
-
-  // The number of blocks of adjacent 'pattern_size' tiles in the ouzzle
-  int nb_pattern = (puzzle->width * puzzle->height - 2 + pattern_size) / pattern_size;
 
-  database->size_sol = nb_pattern;
-  database->database_sol = malloc (database->size_sol * sizeof (*database->database_sol));
-  for (int l = 0; l < nb_pattern; l++)
-  {
-    database->database_sol[l].database = 0;
-    database->database_sol[l].tiles = 0;
-  }
+  free (keys);
+  free (distances);
+}
 
-  // Create 'nb_pattern' blocks of 'pattern_size' adjacent tiles
-  PUZZLE_PRINT (puzzle, _("Patterns for target:\n"));
-  int p_start, p;
-  p_start = 0;
-  for (int l = 0; l < nb_pattern; l++)
-  {
-    int *tiles = 0;
-    int *positions = 0;
-    int nb_tiles = 0;
+// Registry key of a perimeter database: its radius and the base 2 logarithm of the maximum capacity of its hash table
+// (the perimeters built within two memory budgets of the same capacity are the same).
+#define PERIMETER_REGISTRY_SIZE(radius, capacity_bits) ((radius) + ((capacity_bits) << 8))
 
-    // Create a block of 'pattern_size' adjacent tiles
-    PUZZLE_PRINT (puzzle, _("Tiles"));
-    for (p = p_start; nb_tiles < pattern_size && p < puzzle->width * puzzle->height; p++)
-    {
-      int pos = p / puzzle->width;
-      if (pos % 2)
-        pos = (pos + 1) * puzzle->width - p % puzzle->width - 1;
-      else
-        pos = p;
-      if (pattern_size % 2 == 0)
-        pos = puzzle->width * puzzle->height - 1 - pos;
-      if (puzzle->grid_sol[pos])        // not the blank
-      {
-        nb_tiles++;
-        tiles = realloc (tiles, nb_tiles * sizeof (*tiles));
-        tiles[nb_tiles - 1] = puzzle->grid_sol[pos];
-        if (puzzle->parity % 2)
-          PUZZLE_PRINT (puzzle, " %2i", puzzle->width * puzzle->height - tiles[nb_tiles - 1]);
-        else
-          PUZZLE_PRINT (puzzle, " %2i", tiles[nb_tiles - 1]);
-        positions = realloc (positions, nb_tiles * sizeof (*positions));
-        positions[nb_tiles - 1] = pos;
-      }
-    }
+// Base 2 logarithm of the largest capacity of a hash table fitting in 'memory_budget' bytes (kept out of line, so that
+// its loop does not run within the cleanup scopes of its callers).
+static __attribute__ ((noinline)) int
+sliding_puzzle_perimeter_capacity_bits (size_t memory_budget)
+{
+  uint64_t slot_size = sizeof (*((PerimeterDatabase) 0)->keys) + sizeof (*((PerimeterDatabase) 0)->distances);
+  int bits = 4;
+  while (bits < 62 && 2 * ((uint64_t) 1 << bits) * slot_size <= memory_budget)
+    bits++;
+  return bits;
+}
 
-    if (nb_tiles)
+// Thread cancellable
+// Builds the perimeter by breadth-first search from the target, level by level, up to 'radius' moves.
+// The hash table is kept at most half full, and never exceeds 'memory_budget' bytes: the search stops before a level
+// that might not fit, so that the perimeter always holds complete levels (the effective radius can be smaller than asked).
+// If 'toward' is not null, the states at 'g' moves of the target are kept only if g + h <= 'bound', 'h' being their
+// heuristic distance to a start puzzle (goal side of bidirectional searches). The heuristic being consistent,
+// the distances of the kept states are still exact.
+static PerimeterDatabase
+sliding_puzzle_perimeter_build (Puzzle puzzle, int radius, size_t memory_budget, const struct sPerimeterToward *toward,
+                                int bound)
+{
+  int n = puzzle->width * puzzle->height;
+  uint64_t capacity_max = (uint64_t) 1 << sliding_puzzle_perimeter_capacity_bits (memory_budget);
+
+  PerimeterDatabase database = 0;
+  struct sPerimeterBuild b = { 0, 0, 0 };
+  CHECK_ALLOC (b.database = calloc (1, sizeof (*b.database)));
+  atomic_init (&b.database->nbUsers, 1);
+  pthread_cleanup_push (sliding_puzzle_perimeter_build_cleanup, &b);
+
+  for (b.database->bits = 1; (1 << b.database->bits) < n; b.database->bits++)
+    /* nothing */ ;
+  sliding_puzzle_perimeter_rehash (b.database, 16);
+
+  if (!toward)
+    PUZZLE_PRINT (puzzle, _("Create perimeter database using breadth-first search (radius %i)...\n"), radius);
+
+  uint8_t grid[PERIMETER_MAX_TILES];
+  for (int i = 0; i < n; i++)
+    grid[i] = puzzle->grid_sol[i];
+
+  uint64_t nb_frontier = 1, nb_next = 0;
+  CHECK_ALLOC (b.frontier = malloc (sizeof (*b.frontier)));
+  sliding_puzzle_perimeter_pack (grid, n, b.database->bits, b.frontier[0]);
+  uint64_t slot = sliding_puzzle_perimeter_slot (b.database, b.frontier[0]);
+  b.database->keys[slot][0] = b.frontier[0][0];
+  b.database->keys[slot][1] = b.frontier[0][1];
+  b.database->distances[slot] = 0;
+  b.database->count = 1;
+
+  int distance;
+  for (distance = 0; distance < radius && distance < INT8_MAX && nb_frontier; distance++)
+  {
+    // A state has at most 4 neighbours, one of which at least is in the previous level (but for the target).
+    uint64_t count_max = b.database->count + 3 * nb_frontier + 1;
+    if (2 * count_max > capacity_max)
+      break;
+    uint64_t capacity = b.database->capacity;
+    while (capacity < 2 * count_max)
+      capacity *= 2;
+    if (capacity > b.database->capacity)
+      sliding_puzzle_perimeter_rehash (b.database, capacity);
+    CHECK_ALLOC (b.next = malloc ((3 * nb_frontier + 1) * sizeof (*b.next)));
+
+    nb_next = 0;
+    for (uint64_t i = 0; i < nb_frontier; i++)
     {
-      if (database->mirror_sol)
+      sliding_puzzle_perimeter_unpack (b.frontier[i], n, b.database->bits, grid);
+      int blank = 0;
+      while (grid[blank])
+        blank++;
+      // Loop on authorized moves of the empty position (see sliding_puzzle_depth_first_recursive_search).
+      for (int move = blank > 0 ? puzzle->board->upper_nb_perms[blank - 1] : 0; move < puzzle->board->upper_nb_perms[blank]; move++)
       {
-        PUZZLE_PRINT (puzzle, _(", (mirrored along first diagonal)"));
-        for (int t = 0; t < nb_tiles; t++)
-          if (puzzle->parity % 2)
-            PUZZLE_PRINT (puzzle, " %2i", puzzle->width * puzzle->height - database->mirror_sol[tiles[t]]);
-          else
-            PUZZLE_PRINT (puzzle, " %2i", database->mirror_sol[tiles[t]]);
+        int pos = puzzle->board->pos_perm[move];
+        grid[blank] = grid[pos];
+        grid[pos] = 0;
+        uint64_t key[2];
+        sliding_puzzle_perimeter_pack (grid, n, b.database->bits, key);
+        slot = sliding_puzzle_perimeter_slot (b.database, key);
+        if (b.database->keys[slot][0] == PERIMETER_EMPTY
+            && (!toward || distance + 1 + sliding_puzzle_perimeter_toward (toward, grid) <= bound))
+        {
+          b.database->keys[slot][0] = b.next[nb_next][0] = key[0];
+          b.database->keys[slot][1] = b.next[nb_next][1] = key[1];
+          b.database->distances[slot] = distance + 1;
+          b.database->count++;
+          nb_next++;
+        }
+        grid[pos] = grid[blank];
+        grid[blank] = 0;
       }
-
-      // For each block, calculate distances of any positions of the tiles of this block to the target solution.
-      database->database_sol[l].database =
-        sliding_puzzle_heuristic_database_create (puzzle->width, puzzle->height, nb_tiles, positions);
-      database->database_sol[l].tiles = tiles;
-      database->database_sol[l].nb_tiles = nb_tiles;
     }
-    free (positions);
 
-    PUZZLE_PRINT (puzzle, "\n");
-
-    if (p == puzzle->width * puzzle->height)
-      break;
-    else
-      p_start = p;
+    free (b.frontier);
+    b.frontier = b.next;
+    b.next = 0;
+    nb_frontier = nb_next;
 
 #ifdef TEST_CANCELLATION_POINT
     if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
@@ -2078,9 +5468,52 @@ sliding_puzzle_heuristic_database_attach (Puzzle puzzle, int pattern_size)
     // Cancellation point
     pthread_testcancel ();
   }
+  b.database->radius = distance;
 
-  PUZZLE_PRINT (puzzle, _("Create heuristic database using breadth-first search (pattern max size is %i)...DONE\n"),
-                pattern_size);
+  if (!toward)
+    PUZZLE_PRINT (puzzle,
+                  _("Create perimeter database using breadth-first search...DONE (radius %1$i, %2$" PRIu64 " states)\n"),
+                  b.database->radius, b.database->count);
+
+  database = b.database;
+  b.database = 0;
+  pthread_cleanup_pop (1);      // sliding_puzzle_perimeter_build_cleanup (search levels only)
+
+  return database;
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_perimeter_database_attach (Puzzle puzzle, int radius, size_t memory_budget)
+{
+  if (!puzzle || radius <= 0 || puzzle->width * puzzle->height > PERIMETER_MAX_TILES)
+    return 0;
+  if (radius > INT8_MAX)
+    radius = INT8_MAX;
+  int capacity_bits = sliding_puzzle_perimeter_capacity_bits (memory_budget);
+
+  PerimeterDatabase volatile database = 0;
+  struct sRegistryEntry *entry = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+
+  // Cancellation point
+  // Reuse a perimeter already built for the size, target, radius and memory budget of the puzzle, if any.
+  database =
+    sliding_puzzle_registry_lookup (PERIMETER_DATABASE, puzzle->width, puzzle->height,
+                                    PERIMETER_REGISTRY_SIZE (radius, capacity_bits), puzzle->grid_sol, &entry);
+  if (database)
+    PUZZLE_PRINT (puzzle, _("Perimeter database found in registry.\n"));
+  else
+  {
+    pthread_cleanup_push (sliding_puzzle_registry_abort, entry);
+    // Cancellation point
+    database = sliding_puzzle_perimeter_build (puzzle, radius, memory_budget, 0, 0);
+    sliding_puzzle_registry_store (entry, database);
+    pthread_cleanup_pop (0);    // sliding_puzzle_registry_abort
+  }
+
+  pthread_cleanup_push (sliding_puzzle_perimeter_database_cleanup, database);
 
 #ifdef TEST_CANCELLATION_POINT
   if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
@@ -2090,17 +5523,68 @@ sliding_puzzle_heuristic_database_attach (Puzzle puzzle, int pattern_size)
 
   // Cancellation point
   sliding_puzzle_write_begin (puzzle);
-  if (sliding_puzzle_heuristic_database_release (puzzle))
-    PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
-  puzzle->heuristic_database = database;
-  puzzle->heuristic_database->nbUsers = 1;
-  PUZZLE_PRINT (puzzle, _("Heuristic database attached.\n"));
+  if (sliding_puzzle_perimeter_database_release (puzzle))
+    PUZZLE_PRINT (puzzle, _("Perimeter database released.\n"));
+  puzzle->perimeter_database = database;
+  puzzle->d2perimeter = 0;
+  PUZZLE_PRINT (puzzle, _("Perimeter database attached.\n"));
   sliding_puzzle_write_end (puzzle);
 
-  pthread_cleanup_pop (0);      // database_cleanup
+  pthread_cleanup_pop (0);      // sliding_puzzle_perimeter_database_cleanup
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return database->radius;
+}
+
+// Thread cancellable, thread safe
+int
+sliding_puzzle_perimeter_database_share (Puzzle orig, Puzzle dest)
+{
+  if (!orig || !dest)
+    return 0;
+
+  if (orig == dest)
+    return 1;
+
+  // Check for compliant puzzles (same size, same target)
+  if (orig->width != dest->width || orig->height != dest->height)
+    return 0;
+  if (memcmp (dest->grid_sol, orig->grid_sol, orig->width * orig->height * sizeof (*orig->grid_sol)))
+    return 0;
+
+  int volatile ret = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, dest);
+
+  // Cancellation point
+  sliding_puzzle_read_begin (orig);
+  pthread_cleanup_push (sliding_puzzle_solve_read_clean, orig);
+
+  // Cancellation point
+  sliding_puzzle_write_begin (dest);
+
+  if (orig->perimeter_database != dest->perimeter_database)
+  {
+    if (sliding_puzzle_perimeter_database_release (dest))
+      PUZZLE_PRINT (dest, _("Perimeter database released.\n"));
+
+    dest->perimeter_database = sliding_puzzle_perimeter_database_ref (orig->perimeter_database);
+    dest->d2perimeter = 0;
+    if (dest->perimeter_database)
+    {
+      ret = 1;
+      PUZZLE_PRINT (dest, _("Perimeter database shared with puzzle [%p].\n"), (void *) orig);
+    }
+  }
+  sliding_puzzle_write_end (dest);
+  pthread_cleanup_pop (1);      //sliding_puzzle_read_end (orig);
+  pthread_cleanup_pop (0);      //sliding_puzzle_cancellation_msg
+
+  return ret;
 }
 
+/** Perimeter database - END **/
+
 // Thread cancellable, thread safe
 int
 sliding_puzzle_heuristic_database_share (Puzzle orig, Puzzle dest)
@@ -2138,15 +5622,17 @@ sliding_puzzle_heuristic_database_share (Puzzle orig, Puzzle dest)
   // Cancellation point
   sliding_puzzle_write_begin (dest);
 
+  // Sharing supersedes any database previously published to 'dest'.
+  sliding_puzzle_heuristic_database_unref (atomic_exchange (&dest->update->heuristic_database, 0));
+
   if (orig->heuristic_database != dest->heuristic_database)
   {
     if (sliding_puzzle_heuristic_database_release (dest))
       PUZZLE_PRINT (dest, _("Heuristic database released.\n"));
 
-    dest->heuristic_database = orig->heuristic_database;
+    dest->heuristic_database = sliding_puzzle_heuristic_database_ref (orig->heuristic_database);
     if (dest->heuristic_database)
     {
-      dest->heuristic_database->nbUsers++;
       ret = 1;
       PUZZLE_PRINT (dest, _("Heuristic database shared with puzzle [%p].\n"), (void *) orig);
     }
@@ -2158,8 +5644,71 @@ sliding_puzzle_heuristic_database_share (Puzzle orig, Puzzle dest)
   return ret;
 }
 
+// Thread cancellable, thread safe
+// Does not wait for a solver running on 'dest': the heuristic database of 'orig' will be used by the next solver started
+// on 'dest', and the previous heuristic database of 'dest' will be released then, once no longer in use.
+int
+sliding_puzzle_heuristic_database_publish (Puzzle orig, Puzzle dest)
+{
+  if (!orig || !dest)
+    return 0;
+
+  if (orig == dest)
+    return 1;
+
+  // Check for compliant puzzles (same size and target)
+  if (orig->width != dest->width || orig->height != dest->height)
+    return 0;
+  if (memcmp (dest->grid_sol, orig->grid_sol, orig->width * orig->height * sizeof (*orig->grid_sol)))
+    return 0;
+
+  HeuristicDatabase heuristic_database = 0;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, dest);
+
+  // Cancellation point
+  sliding_puzzle_read_begin (orig);
+  // The reference held by 'orig' keeps the database alive while another one is taken.
+  heuristic_database = sliding_puzzle_heuristic_database_ref (orig->heuristic_database);
+  sliding_puzzle_read_end (orig);
+
+  if (heuristic_database)
+    sliding_puzzle_heuristic_database_unref (atomic_exchange (&dest->update->heuristic_database, heuristic_database));
+
+  pthread_cleanup_pop (0);      //sliding_puzzle_cancellation_msg
+
+  return heuristic_database ? 1 : 0;
+}
+
 /** Heuristic database creation for puzzle - END **/
 
+// Puts the databases published to the puzzle in use, releasing the replaced ones.
+// Needs write access to the puzzle.
+static void
+sliding_puzzle_database_update (Puzzle puzzle)
+{
+  if (!puzzle->update)
+    return;
+
+  HeuristicDatabase heuristic_database = atomic_exchange (&puzzle->update->heuristic_database, 0);
+  if (heuristic_database)
+  {
+    if (sliding_puzzle_heuristic_database_release (puzzle))
+      PUZZLE_PRINT (puzzle, _("Heuristic database released.\n"));
+    puzzle->heuristic_database = heuristic_database;
+    PUZZLE_PRINT (puzzle, _("Heuristic database updated.\n"));
+  }
+
+  CycleDatabase cycle_database = atomic_exchange (&puzzle->update->cycle_database, 0);
+  if (cycle_database)
+  {
+    if (sliding_puzzle_cycle_bank_release (puzzle))
+      PUZZLE_PRINT (puzzle, _("Cycle bank released.\n"));
+    puzzle->cycle_database = cycle_database;
+    PUZZLE_PRINT (puzzle, _("Cycle bank updated.\n"));
+  }
+}
+
 /** Helpers - END **/
 
 /** Puzzle solvers - BEGIN **/
@@ -2179,14 +5728,20 @@ sliding_puzzle_solve_RBFS (Puzzle puzzle)
   // Cancellation point
   sliding_puzzle_write_begin (puzzle);
   pthread_cleanup_push (sliding_puzzle_solve_write_clean, puzzle);
+  sliding_puzzle_progress_start (puzzle);
+  pthread_cleanup_push (sliding_puzzle_progress_stop, puzzle);
 
   puzzle->solved = 0;
   puzzle->solution_length = 0;
   free (puzzle->solution);
   puzzle->solution = 0;
 
+  sliding_puzzle_database_update (puzzle);
+
   PUZZLE_PRINT (puzzle, _("Solve puzzle...\n"));
   PUZZLE_PRINT (puzzle, _("  Using RBFS...\n"));
+  if (puzzle->nb_threads > 1)
+    PUZZLE_PRINT (puzzle, _("  Using %i threads.\n"), puzzle->nb_threads);
   if (puzzle->heuristic_database)
     PUZZLE_PRINT (puzzle, _("  Using heuristic database.\n"));
   if (puzzle->cycle_database)
@@ -2207,8 +5762,11 @@ sliding_puzzle_solve_RBFS (Puzzle puzzle)
   b.pBufferLength = &bufferLength;
   pthread_cleanup_push (sliding_puzzle_buffer_RBFS_cleanup, &b);
 
+  root.node = (struct sNode) {0};
+  pthread_cleanup_push (sliding_puzzle_node_cleanup, &root.node);
+  sliding_puzzle_node_init (puzzle, &root.node);
+
   PUZZLE_PRINT (puzzle, _("Depth: "));
-  root.node = *puzzle;
   root.F = depth;
   root.move = 0;
 #ifdef TEST_CANCELLATION_POINT
@@ -2219,10 +5777,32 @@ sliding_puzzle_solve_RBFS (Puzzle puzzle)
   // Cancellation point
   pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
 
-  // Call to BFRS
-  depth =
-    sliding_puzzle_best_first_recursive_search (&root, /* depth = */ 0, /* V = */ depth, /* max_depth = */ INT_MAX,
-                                                &buffer, &bufferLength);
+  // A complete distance table gives the solution by greedy descent: no search is needed.
+  int *moves = 0;
+  int length = puzzle->distance_table ? sliding_puzzle_distance_table_descend (puzzle, &moves) : -1;
+  if (length >= 0)
+  {
+    PUZZLE_PRINT (puzzle, _("  Using distance table.\n"));
+    CHECK_ALLOC (buffer = calloc (length + 1, sizeof (*buffer)));
+    for (int i = 0; i < length; i++)
+      buffer[i].move = moves[i];
+    bufferLength = depth = length;
+    root.node.solved = 1;
+  }
+  else if (puzzle->nb_threads > 1 && !puzzle->solved)
+    // Call to parallel BFRS
+    depth = sliding_puzzle_parallel_best_first_search (puzzle, &root, puzzle->nb_threads, &buffer, &bufferLength);
+  else
+  {
+    // The search looks up the heuristic tables of the NUMA node of the calling thread.
+    struct sPuzzle problem = *puzzle;
+    problem.heuristic_database = sliding_puzzle_heuristic_database_local (puzzle->heuristic_database);
+    // Call to BFRS
+    depth =
+      sliding_puzzle_best_first_recursive_search_select (&problem) (&problem, &root, /* depth = */ 0, /* V = */ depth,
+                                                                    /* max_depth = */ INT_MAX, &buffer, &bufferLength);
+  }
+  free (moves);
 
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
   PUZZLE_PRINT (puzzle, "\n");
@@ -2285,7 +5865,14 @@ sliding_puzzle_solve_RBFS (Puzzle puzzle)
       puzzle->solution_shower (puzzle, depth + 1, 0, 0);
   }
 
+  uintmax_t nbNodes = 0;
+  for (int i = 0; i < bufferLength; i++)
+    nbNodes += buffer[i].nbGeneratedNodes;
+  sliding_puzzle_progress_result (puzzle, root.node.solved > 0 ? depth : root.F, nbNodes);
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_node_cleanup
   pthread_cleanup_pop (1);      // sliding_puzzle_solve_RBFS_cleanup
+  pthread_cleanup_pop (1);      // sliding_puzzle_progress_stop
   pthread_cleanup_pop (1);      // sliding_puzzle_solve_wr_clean
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
 
@@ -2310,14 +5897,20 @@ sliding_puzzle_solve_IDA (Puzzle puzzle)
   // Cancellation point
   sliding_puzzle_write_begin (puzzle);
   pthread_cleanup_push (sliding_puzzle_solve_write_clean, puzzle);
+  sliding_puzzle_progress_start (puzzle);
+  pthread_cleanup_push (sliding_puzzle_progress_stop, puzzle);
 
   puzzle->solved = 0;
   puzzle->solution_length = 0;
   free (puzzle->solution);
   puzzle->solution = 0;
 
+  sliding_puzzle_database_update (puzzle);
+
   PUZZLE_PRINT (puzzle, _("Solve puzzle...\n"));
   PUZZLE_PRINT (puzzle, _("  Using IDA*...\n"));
+  if (puzzle->nb_threads > 1)
+    PUZZLE_PRINT (puzzle, _("  Using %i threads.\n"), puzzle->nb_threads);
   if (puzzle->heuristic_database)
     PUZZLE_PRINT (puzzle, _("  Using heuristic database.\n"));
   if (puzzle->cycle_database)
@@ -2336,13 +5929,64 @@ sliding_puzzle_solve_IDA (Puzzle puzzle)
   b.pBufferLength = &prev_depth;
   pthread_cleanup_push (sliding_puzzle_buffer_IDA_cleanup, &b);
 
+  struct sNode root = { 0 };
+  pthread_cleanup_push (sliding_puzzle_node_cleanup, &root);
+  sliding_puzzle_node_init (puzzle, &root);
+
+  if (puzzle->perimeter_database)
+  {
+    PUZZLE_PRINT (puzzle, _("  Using perimeter database (radius %i).\n"), puzzle->perimeter_database->radius);
+    next_depth = sliding_puzzle_perimeter_sharpen (puzzle, &root);
+    puzzle->d2perimeter = root.d2perimeter;
+  }
+
+  // A complete distance table gives the solution by greedy descent: no search is needed.
+  if (puzzle->distance_table)
+  {
+    PUZZLE_PRINT (puzzle, _("  Using distance table.\n"));
+    int *moves = 0;
+    int length = sliding_puzzle_distance_table_descend (puzzle, &moves);
+    if (length >= 0)
+    {
+      CHECK_ALLOC (buffer = calloc (length + 1, sizeof (*buffer)));
+      for (int i = 0; i < length; i++)
+        buffer[i].move = moves[i];
+      prev_depth = length;
+      puzzle->solved = 1;
+    }
+    free (moves);
+  }
+
   PUZZLE_PRINT (puzzle, _("Depth: "));
+  // Several threads search several thresholds at once.
+  if (!puzzle->solved && puzzle->nb_threads > 1 && next_depth < INT_MAX)
+  {
+    // Cancellation point
+    int length = sliding_puzzle_window_depth_first_search (puzzle, next_depth, puzzle->nb_threads, &buffer, &prev_depth);
+    if (length >= 0)
+    {
+      prev_depth = length;
+      puzzle->solved = 1;
+    }
+    else
+      next_depth = INT_MAX;
+  }
+
+  // The search looks up the heuristic tables of the NUMA node of the calling thread.
+  struct sPuzzle problem = *puzzle;
+  problem.heuristic_database = sliding_puzzle_heuristic_database_local (puzzle->heuristic_database);
+  SearchDFRS search = sliding_puzzle_depth_first_recursive_search_select (&problem);
   // Try to solve the puzzle with a solution not longer than 'next_depth'.
   // Increase next_depth as long as the puzzle is not solved.
   while (!puzzle->solved && next_depth < INT_MAX)
   {
     PUZZLE_PRINT (puzzle, "%i.", next_depth);
 
+    uintmax_t nbNodes = 0;
+    for (int i = 0; i < prev_depth; i++)
+      nbNodes += buffer[i].nbGeneratedNodes;
+    sliding_puzzle_progress_iteration (puzzle, next_depth, next_depth, &nbNodes);
+
 #ifdef TEST_CANCELLATION_POINT
     if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
         && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
@@ -2353,26 +5997,33 @@ sliding_puzzle_solve_IDA (Puzzle puzzle)
 
     buffer = realloc (buffer, next_depth * sizeof (*buffer));
 
+    int cell = NODE_CELL (puzzle->width * puzzle->height);
     for (int i = prev_depth; i < next_depth; i++)
     {
-      buffer[i].grid = malloc (puzzle->height * puzzle->width * sizeof (*buffer[i].grid));      // needs cancel cleanup
-      buffer[i].pos = malloc (puzzle->height * puzzle->width * sizeof (*buffer[i].pos));        // needs cancel cleanup
+      buffer[i].grid = malloc (puzzle->height * puzzle->width * cell);  // needs cancel cleanup
+      buffer[i].pos = malloc (puzzle->height * puzzle->width * cell);   // needs cancel cleanup
       buffer[i].nbGeneratedNodes = 0;
     }
 
     if (puzzle->cycle_database)
-      puzzle->cycle_state = ACM_reset (puzzle->cycle_database->cycles);
+      root.cycle_state = puzzle->cycle_state = ACM_reset (puzzle->cycle_database->cycles);
     prev_depth = next_depth;
     // Call to DFRS
     // Returns the smallest minimal distance to solution for all possible moves of tile.
     // This distance will be higher than prev_depth if not solutions were found.
-    next_depth = sliding_puzzle_depth_first_recursive_search (puzzle, prev_depth, 0, buffer);
+    next_depth = search (&problem, &root, prev_depth, -1, buffer);
+    puzzle->solved = root.solved;
 
     // Cancellation point
     pthread_testcancel ();
   }                             // end while
   PUZZLE_PRINT (puzzle, "\n");
 
+  uintmax_t nbNodes = 0;
+  for (int i = 0; i < prev_depth; i++)
+    nbNodes += buffer[i].nbGeneratedNodes;
+  sliding_puzzle_progress_result (puzzle, puzzle->solved > 0 ? prev_depth : next_depth, nbNodes);
+
   if (puzzle->solved > 0)
   {
     if (prev_depth)
@@ -2434,13 +6085,535 @@ sliding_puzzle_solve_IDA (Puzzle puzzle)
   else                          // should not happen
     prev_depth = -1;
 
+  pthread_cleanup_pop (1);      // sliding_puzzle_node_cleanup
   pthread_cleanup_pop (1);      // sliding_puzzle_solve_IDA_cleanup
+  pthread_cleanup_pop (1);      // sliding_puzzle_progress_stop
   pthread_cleanup_pop (1);      // sliding_puzzle_solve_wr_clean
   pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
 
   return prev_depth;
 }
 
+struct BufferBIDA
+{
+  struct BufferIDA *path;
+  PerimeterDatabase goal;
+};
+
+static void
+sliding_puzzle_buffer_BIDA_cleanup (void *arg)
+{
+  struct BufferBIDA *b = arg;
+  free (b->path);
+  sliding_puzzle_perimeter_database_unref (b->goal);
+}
+
+// Thread cancellable, thread safe
+// Bidirectional IDA* (front-to-end, see struct sBidirectionalSearch): the goal side of each threshold is private to
+// the search (within BIDA_MEMORY_BUDGET), and released at the end. Databases attached to the puzzle are not modified.
+int
+sliding_puzzle_solve_BIDA (Puzzle puzzle)
+{
+  // Cancellation point
+  if (puzzle->width * puzzle->height > PERIMETER_MAX_TILES)
+  {
+    PUZZLE_PRINT (puzzle, _("  No goal-side search for puzzles of more than %i tiles.\n"), PERIMETER_MAX_TILES);
+    return sliding_puzzle_solve_IDA (puzzle);
+  }
+
+  int length = -1;
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+  pthread_cleanup_push (sliding_puzzle_solve_write_clean, puzzle);
+  sliding_puzzle_progress_start (puzzle);
+  pthread_cleanup_push (sliding_puzzle_progress_stop, puzzle);
+
+  puzzle->solved = 0;
+  puzzle->solution_length = 0;
+  free (puzzle->solution);
+  puzzle->solution = 0;
+
+  sliding_puzzle_database_update (puzzle);
+
+  PUZZLE_PRINT (puzzle, _("Solve puzzle...\n"));
+  PUZZLE_PRINT (puzzle, _("  Using bidirectional IDA*...\n"));
+  if (puzzle->heuristic_database)
+    PUZZLE_PRINT (puzzle, _("  Using heuristic database.\n"));
+
+  int size = puzzle->width * puzzle->height;
+  int volatile threshold = sliding_puzzle_initialize_distances_to_solutions (puzzle);
+
+  struct BufferBIDA b = { 0, 0 };
+  pthread_cleanup_push (sliding_puzzle_buffer_BIDA_cleanup, &b);
+
+  // The search looks up the heuristic tables of the NUMA node of the calling thread.
+  struct sPuzzle problem = *puzzle;
+  problem.heuristic_database = sliding_puzzle_heuristic_database_local (puzzle->heuristic_database);
+  struct sBidirectionalSearch s = {.puzzle = &problem,.length = -1 };
+  struct sPerimeterToward toward;
+  sliding_puzzle_perimeter_toward_init (&problem, puzzle->pos, &toward);
+  for (int i = 0; i < size; i++)
+  {
+    s.grid[i] = puzzle->grid[i];
+    s.pos[i] = puzzle->pos[i];
+  }
+
+  PUZZLE_PRINT (puzzle, _("Depth: "));
+  while (s.length == -1 && threshold < INT_MAX)
+  {
+    PUZZLE_PRINT (puzzle, "%i.", threshold);
+    uintmax_t nodes = s.nodes;
+    sliding_puzzle_progress_iteration (puzzle, threshold, threshold, &nodes);
+
+    CHECK_ALLOC (b.path = realloc (b.path, (threshold + 1) * sizeof (*b.path)));
+    // Cancellation point
+    b.goal = sliding_puzzle_perimeter_build (puzzle, threshold / 2, BIDA_MEMORY_BUDGET, &toward, threshold);
+
+    s.goal = b.goal;
+    s.path = b.path;
+    s.threshold = threshold;
+    s.next = INT_MAX;
+    sliding_puzzle_bidirectional_search (&s, 0, puzzle->pos[0], -1);
+    threshold = s.next;
+
+    sliding_puzzle_perimeter_database_unref (b.goal);
+    b.goal = 0;
+
+#ifdef TEST_CANCELLATION_POINT
+    if (!strcmp (TEST_CANCELLATION_POINT, __func__) && thread_cancellation_point_test
+        && pthread_equal (*thread_cancellation_point_test, pthread_self ()))
+      pthread_cancel (*thread_cancellation_point_test);
+#endif
+    // Cancellation point
+    pthread_testcancel ();
+  }
+  PUZZLE_PRINT (puzzle, "\n");
+
+  length = s.length >= 0 ? s.length : -1;
+  sliding_puzzle_progress_result (puzzle, length >= 0 ? length : threshold, s.nodes);
+
+  if (length >= 0)
+  {
+    puzzle->solved = 1;
+    PUZZLE_PRINT (puzzle, _("Solved:\n Depth: %i\n Path:\n"), length);
+
+    int grid[PERIMETER_MAX_TILES];
+    memcpy (grid, puzzle->grid, size * sizeof (*grid));
+    int blank = puzzle->pos[0];
+
+    puzzle->solution_length = length;
+    CHECK_ALLOC (puzzle->solution = malloc ((length + 1) * sizeof (*puzzle->solution)));
+
+    for (int i = 0; i < length; i++)
+    {
+      int tile, move;
+      if (puzzle->parity % 2 == 0)
+      {
+        tile = grid[blank + b.path[i].move];
+        move =
+          b.path[i].move == -puzzle->width ? 'd' : b.path[i].move == puzzle->width ? 'u' :
+          b.path[i].move == -1 ? 'r' : 'l';
+      }
+      else
+      {
+        tile = size - grid[blank + b.path[i].move];
+        move =
+          b.path[i].move == -puzzle->width ? 'u' : b.path[i].move == puzzle->width ? 'd' :
+          b.path[i].move == -1 ? 'l' : 'r';
+      }
+      if (puzzle->solution_shower)
+        puzzle->solution_shower (puzzle, i + 1, tile, move);
+      else
+        PUZZLE_PRINT (puzzle, " %2i(%c)", tile, move);
+      grid[blank] = grid[blank + b.path[i].move];
+      grid[blank + b.path[i].move] = 0;
+      blank += b.path[i].move;
+
+      puzzle->solution[i] = tile;
+    }
+    PUZZLE_PRINT (puzzle, _("\n Generated nodes: TOTAL:%" PRIuMAX "\n"), s.nodes);
+    if (puzzle->solution_shower)
+      puzzle->solution_shower (puzzle, length + 1, 0, 0);
+  }
+  else
+    puzzle->solved = -1;
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_buffer_BIDA_cleanup
+  pthread_cleanup_pop (1);      // sliding_puzzle_progress_stop
+  pthread_cleanup_pop (1);      // sliding_puzzle_solve_wr_clean
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return length;
+}
+
+// Configurations raced by sliding_puzzle_solve_portfolio.
+static const struct sPortfolioConfiguration
+{
+  const char *name;
+  int (*solve) (Puzzle);
+  int cycles;                   // with cycle detection
+} portfolio_configurations[] = {
+  {"IDA* with cycle detection", sliding_puzzle_solve_IDA, 1},
+  {"RBFS with cycle detection", sliding_puzzle_solve_RBFS, 1},
+  {"IDA*", sliding_puzzle_solve_IDA, 0},
+  {"RBFS", sliding_puzzle_solve_RBFS, 0},
+};
+
+#define PORTFOLIO_SIZE (sizeof (portfolio_configurations) / sizeof (*portfolio_configurations))
+
+struct sPortfolio
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t finished;
+  atomic_int stop;              // set to abandon the searches of the other configurations
+  struct
+  {
+    const struct sPortfolioConfiguration *configuration;
+    Puzzle puzzle;              // copy of the puzzle, sharing its databases
+    int length;
+  } runs[PORTFOLIO_SIZE];
+  int nb_runs;
+  pthread_t threads[PORTFOLIO_SIZE];
+  int nb_created;
+  int nb_started;               // to assign a run to each thread
+  int nb_finished;
+  int winner;                   // -1 while none
+};
+
+// Thread cancellable
+static void *
+sliding_puzzle_portfolio_run (void *arg)
+{
+  struct sPortfolio *p = arg;
+
+  ASSERT_FALSE (pthread_mutex_lock (&p->mutex), _("POSIX thread error"));
+  int run = p->nb_started++;
+  ASSERT_FALSE (pthread_mutex_unlock (&p->mutex), _("POSIX thread error"));
+
+  // Cancellation point
+  int length = p->runs[run].configuration->solve (p->runs[run].puzzle);
+
+  ASSERT_FALSE (pthread_mutex_lock (&p->mutex), _("POSIX thread error"));
+  p->runs[run].length = length;
+  if (length >= 0 && p->winner < 0)
+  {
+    p->winner = run;
+    atomic_store_explicit (&p->stop, 1, memory_order_relaxed);
+  }
+  p->nb_finished++;
+  ASSERT_FALSE (pthread_cond_signal (&p->finished), _("POSIX thread error"));
+  ASSERT_FALSE (pthread_mutex_unlock (&p->mutex), _("POSIX thread error"));
+
+  return 0;
+}
+
+static void
+sliding_puzzle_portfolio_unlock (void *arg)
+{
+  struct sPortfolio *p = arg;
+  pthread_mutex_unlock (&p->mutex);
+}
+
+// Cleaner: abandons the searches still running, and releases the copies of the puzzle.
+static void
+sliding_puzzle_portfolio_cleanup (void *arg)
+{
+  struct sPortfolio *p = arg;
+  atomic_store_explicit (&p->stop, 1, memory_order_relaxed);
+  for (int i = 0; i < p->nb_created; i++)
+    pthread_join (p->threads[i], 0);
+  for (int i = 0; i < p->nb_runs; i++)
+    sliding_puzzle_release (p->runs[i].puzzle);
+  pthread_cond_destroy (&p->finished);
+  pthread_mutex_destroy (&p->mutex);
+}
+
+// Thread cancellable, thread safe
+// Races the configurations on copies of the puzzle: the first optimal solution wins, the other searches are abandoned.
+int
+sliding_puzzle_solve_portfolio (Puzzle puzzle, const char **winner_name)
+{
+  int volatile length = -1;
+  int n = puzzle->width * puzzle->height;
+  int *grid = 0;
+
+  struct sPortfolio p = {.winner = -1 };
+  pthread_mutex_init (&p.mutex, 0);
+  pthread_cond_init (&p.finished, 0);
+  atomic_init (&p.stop, 0);
+
+  pthread_cleanup_push (sliding_puzzle_cancellation_msg, puzzle);
+  // Cancellation point
+  sliding_puzzle_write_begin (puzzle);
+  pthread_cleanup_push (sliding_puzzle_solve_write_clean, puzzle);
+  sliding_puzzle_progress_start (puzzle);
+  pthread_cleanup_push (sliding_puzzle_progress_stop, puzzle);
+  CHECK_ALLOC (grid = malloc (n * sizeof (*grid)));
+  pthread_cleanup_push (free, grid);
+  pthread_cleanup_push (sliding_puzzle_portfolio_cleanup, &p);
+
+  puzzle->solved = 0;
+  puzzle->solution_length = 0;
+  free (puzzle->solution);
+  puzzle->solution = 0;
+
+  sliding_puzzle_database_update (puzzle);
+
+  PUZZLE_PRINT (puzzle, _("Solve puzzle...\n"));
+  PUZZLE_PRINT (puzzle, _("  Using a portfolio of solvers...\n"));
+
+  // One copy of the puzzle per configuration: copies share the read-only databases of the puzzle.
+  sliding_puzzle_grid_get (puzzle, grid);
+  for (size_t i = 0; i < PORTFOLIO_SIZE; i++)
+  {
+    if (portfolio_configurations[i].cycles && !puzzle->cycle_database)
+      continue;
+    Puzzle copy = sliding_puzzle_init4 (puzzle->width, puzzle->height, grid, 0);
+    CHECK_ALLOC (copy);
+    if (portfolio_configurations[i].cycles)
+      copy->cycle_database = sliding_puzzle_cycle_database_ref (puzzle->cycle_database);
+    copy->heuristic_database = sliding_puzzle_heuristic_database_ref (puzzle->heuristic_database);
+    copy->distance_table = sliding_puzzle_distance_table_ref (puzzle->distance_table);
+    copy->perimeter_database = sliding_puzzle_perimeter_database_ref (puzzle->perimeter_database);
+    copy->stop = &p.stop;
+    p.runs[p.nb_runs].configuration = &portfolio_configurations[i];
+    p.runs[p.nb_runs].puzzle = copy;
+    p.runs[p.nb_runs].length = -1;
+    p.nb_runs++;
+  }
+
+  ASSERT_FALSE (pthread_mutex_lock (&p.mutex), _("POSIX thread error"));
+  pthread_cleanup_push (sliding_puzzle_portfolio_unlock, &p);
+  for (; p.nb_created < p.nb_runs; p.nb_created++)
+    if (pthread_create (&p.threads[p.nb_created], 0, sliding_puzzle_portfolio_run, &p))
+      break;
+  // Wait for the first configuration to solve the puzzle, or for all of them to fail.
+  while (p.winner < 0 && p.nb_finished < p.nb_created)
+    // Cancellation point
+    ASSERT_FALSE (pthread_cond_wait (&p.finished, &p.mutex), _("POSIX thread error"));
+  pthread_cleanup_pop (1);      // sliding_puzzle_portfolio_unlock
+
+  if (p.winner >= 0)
+  {
+    Puzzle winner = p.runs[p.winner].puzzle;
+    length = p.runs[p.winner].length;
+
+    struct sPuzzleProgress progress;
+    sliding_puzzle_progress_get (winner, &progress);
+    if (winner_name)
+      *winner_name = p.runs[p.winner].configuration->name;
+    PUZZLE_PRINT (puzzle, _("%1$s won: %2$i moves, %3$llu generated nodes in %4$.3fs.\n"),
+                  p.runs[p.winner].configuration->name, length, progress.nodes, progress.elapsed);
+    sliding_puzzle_progress_result (puzzle, length, progress.nodes);
+
+    puzzle->solved = 1;
+    puzzle->solution_length = length;
+    CHECK_ALLOC (puzzle->solution = malloc ((length + 1) * sizeof (*puzzle->solution)));
+    memcpy (puzzle->solution, winner->solution, length * sizeof (*puzzle->solution));
+
+    // Replay the solution for the move handler.
+    if (puzzle->solution_shower)
+    {
+      int blank = 0;
+      while (grid[blank])
+        blank++;
+      for (int i = 0; i < length; i++)
+      {
+        int pos = 0;
+        while (grid[pos] != puzzle->solution[i])
+          pos++;
+        int move = pos == blank - puzzle->width ? 'd' : pos == blank + puzzle->width ? 'u' : pos == blank - 1 ? 'r' : 'l';
+        puzzle->solution_shower (puzzle, i + 1, puzzle->solution[i], move);
+        grid[blank] = grid[pos];
+        grid[pos] = 0;
+        blank = pos;
+      }
+      puzzle->solution_shower (puzzle, length + 1, 0, 0);
+    }
+  }
+
+  pthread_cleanup_pop (1);      // sliding_puzzle_portfolio_cleanup
+  pthread_cleanup_pop (1);      // free (grid)
+  pthread_cleanup_pop (1);      // sliding_puzzle_progress_stop
+  pthread_cleanup_pop (1);      // sliding_puzzle_solve_write_clean
+  pthread_cleanup_pop (0);      // sliding_puzzle_cancellation_msg
+
+  return length;
+}
+
 /** Puzzle solvers - END **/
 
+/** Instance generation - BEGIN **/
+#define GENERATE_WALKS_MAX 1000 // random walks tried per puzzle before giving up
+
+struct sGenerator
+{
+  Puzzle model;
+  int distance;
+  int count;
+  int *grids;
+  unsigned long long *nodes;
+  int *target;                  // target of the puzzles of the parity of the model
+  uint64_t key;                 // puzzle i is drawn from the random stream key + i, whatever the thread
+  atomic_int next;
+  atomic_int failed;
+};
+
+// Thread safe
+// Walks randomly from the target until the optimal distance of the reached puzzle is exactly 'distance'.
+static void *
+sliding_puzzle_generate_worker (void *arg)
+{
+  struct sGenerator *g = arg;
+  int width = g->model->width;
+  int size = g->model->width * g->model->height;
+  int parity = g->model->parity % 2;
+  int *grid;
+  CHECK_ALLOC (grid = malloc (size * sizeof (*grid)));
+
+  for (int index; !atomic_load (&g->failed) && (index = atomic_fetch_add (&g->next, 1)) < g->count;)
+  {
+    random_stream (g->key + index);
+    int length = -1;
+    unsigned long long nodes = 0;
+    for (int attempt = 0; length != g->distance; attempt++)
+    {
+      if (attempt == GENERATE_WALKS_MAX)
+      {
+        atomic_store (&g->failed, 1);
+        break;
+      }
+
+      // Random walk from the target, never undoing the previous move.
+      memcpy (grid, g->target, size * sizeof (*grid));
+      int blank = 0, previous = -1;
+      while (grid[blank])
+        blank++;
+
+      // The parity of the optimal distance is the parity of the length of the walk:
+      // the walk is checked once it is 'distance' moves long, then every other move,
+      // until its optimal distance reaches 'distance' (accepted) or goes beyond (restarted).
+      // Puzzles of the other parity have the other target and are walked through without being checked.
+      // Walks are bounded, for distances close to the diameter of the puzzle.
+      length = -1;
+      for (int walk = 0; walk <= 4 * g->distance + size; walk++)
+      {
+        if (walk >= g->distance && (walk - g->distance) % 2 == 0)
+        {
+          Puzzle puzzle = sliding_puzzle_init (g->model->width, g->model->height, grid, 0);
+          int checked = sliding_puzzle_parity_get (puzzle) == parity;
+          if (checked)
+          {
+            // The databases of the model are those of its parity.
+            sliding_puzzle_cycle_database_share (g->model, puzzle);
+            sliding_puzzle_heuristic_database_share (g->model, puzzle);
+            length = sliding_puzzle_solve_IDA (puzzle);
+            struct sPuzzleProgress progress;
+            sliding_puzzle_progress_get (puzzle, &progress);
+            nodes = progress.nodes;
+          }
+          sliding_puzzle_release (puzzle);
+          if (checked && length < 0)    // should not happen
+            atomic_store (&g->failed, 1);
+          if (checked && (length < 0 || length >= g->distance))
+            break;
+        }
+
+        int next[4], nb_next = 0;
+        if (blank % width > 0 && blank - 1 != previous)
+          next[nb_next++] = blank - 1;
+        if (blank % width < width - 1 && blank + 1 != previous)
+          next[nb_next++] = blank + 1;
+        if (blank >= width && blank - width != previous)
+          next[nb_next++] = blank - width;
+        if (blank + width < size && blank + width != previous)
+          next[nb_next++] = blank + width;
+        if (!nb_next)           // 1xN puzzle at its end
+          next[nb_next++] = previous;
+
+        int pos = next[alea (nb_next - 1)];
+        grid[blank] = grid[pos];
+        grid[pos] = 0;
+        previous = blank;
+        blank = pos;
+      }
+
+      if (atomic_load (&g->failed))
+        break;
+    }
+
+    if (length == g->distance)
+    {
+      memcpy (g->grids + index * size, grid, size * sizeof (*grid));
+      if (g->nodes)
+        g->nodes[index] = nodes;
+    }
+  }
+
+  free (grid);
+  return 0;
+}
+// Thread safe
+int
+sliding_puzzle_generate (Puzzle model, int distance, int count, int grids[], unsigned long long nodes[],
+                         int nb_threads)
+{
+  if (!model || !model->update || distance < 0 || count <= 0 || !grids)
+    return 0;
+  if (model->width * model->height < 3 && distance > 1)
+    return 0;
+  if (nb_threads <= 0)
+    nb_threads = 1;
+  if (nb_threads > count)
+    nb_threads = count;
+
+  // Target of the model, as returned by sliding_puzzle_grid_get: the empty spot in the upper left corner,
+  // or in the lower right corner for puzzles of odd parity (central symmetry).
+  int size = model->width * model->height;
+  int *target;
+  CHECK_ALLOC (target = malloc (size * sizeof (*target)));
+  for (int pos = 0; pos < size; pos++)
+    target[pos] = model->parity % 2 ? (pos + 1) % size : pos;
+  // On boards of odd height, the lower right corner target has an even parity:
+  // no puzzle of odd parity can be generated.
+  Puzzle puzzle = sliding_puzzle_init (model->width, model->height, target, 0);
+  int valid = puzzle && sliding_puzzle_parity_get (puzzle) == model->parity % 2;
+  sliding_puzzle_release (puzzle);
+  if (!valid)
+  {
+    free (target);
+    return 0;
+  }
+
+  // The puzzles depend on the seed only, not on the number of threads or on their scheduling. The calling thread
+  // gets its own stream back once its share is done.
+  uint64_t key = random_next ();
+  struct sRandomState caller = random_state;
+  struct sGenerator g = {.model = model,.distance = distance,.count = count,.grids = grids,.nodes = nodes,
+    .target = target,.key = key
+  };
+  atomic_init (&g.next, 0);
+  atomic_init (&g.failed, 0);
+
+  pthread_t *threads;
+  CHECK_ALLOC (threads = malloc ((nb_threads - 1) * sizeof (*threads) + 1));
+  int nb_started = 0;
+  for (; nb_started < nb_threads - 1; nb_started++)
+    if (pthread_create (&threads[nb_started], 0, sliding_puzzle_generate_worker, &g))
+      break;
+  // The calling thread works as well.
+  sliding_puzzle_generate_worker (&g);
+  random_state = caller;
+  for (int i = 0; i < nb_started; i++)
+    pthread_join (threads[i], 0);
+  free (threads);
+  free (target);
+
+  return atomic_load (&g.failed) ? 0 : count;
+}
+
+/** Instance generation - END **/
+
 /** User interface - END **/
@@ -70,6 +70,8 @@ typedef struct sPuzzle *Puzzle;
 Puzzle sliding_puzzle_init2 (int width, int height);
 Puzzle sliding_puzzle_init4 (int width, int height, int *grid, FILE * f);
 #  define sliding_puzzle_init(w, h, ...)            VFUNC(sliding_puzzle_init, w, h, __VA_ARGS__)
+/** Seed the generator of random puzzles (sliding_puzzle_init2) for reproducible sequences **/
+void sliding_puzzle_random_seed (unsigned long long seed);
 int sliding_puzzle_release (Puzzle puzzle);
 
 /** Set and get properties **/
@@ -80,10 +82,45 @@ void sliding_puzzle_solution_get (Puzzle puzzle, int solution[]);
 typedef void (*Puzzle_move_handler) (Puzzle puzzle, int move_number, int tile, int move);
 Puzzle_move_handler sliding_puzzle_move_handler_set (Puzzle puzzle, Puzzle_move_handler mh);
 FILE *sliding_puzzle_stream_set (Puzzle puzzle, FILE * f);
+/** Number of threads used by the solvers (1 by default). Returns the previous number. **/
+/** RBFS searches subtrees of the puzzle concurrently, IDA* searches successive thresholds concurrently, **/
+/** both keeping the solution optimal. **/
+int sliding_puzzle_threads_set (Puzzle puzzle, int nb_threads);
 
 /** Solve puzzle using either IDA* or RBFS algorithm **/
 int sliding_puzzle_solve_IDA (Puzzle puzzle);
 int sliding_puzzle_solve_RBFS (Puzzle puzzle);
+/** Solve puzzle using front-to-end bidirectional IDA*: for each threshold, the states around the target heading **/
+/** for the puzzle (256 MB at most, released after the search) are met by IDA* from the puzzle, half as deep. **/
+/** Puzzles of more than 25 tiles are solved by IDA*. The databases of the puzzle are used but not modified. **/
+int sliding_puzzle_solve_BIDA (Puzzle puzzle);
+/** Solve puzzle racing IDA* and RBFS, with and without cycle detection (if a cycle database is attached), **/
+/** on copies of the puzzle sharing its databases. The first optimal solution wins, the other searches are abandoned. **/
+/** The name of the winning configuration is returned in '*winner' if not null. **/
+int sliding_puzzle_solve_portfolio (Puzzle puzzle, const char **winner);
+
+/** Query the progress of a solver running on a puzzle, without blocking **/
+struct sPuzzleProgress
+{
+  int running;                  // 1 while a solver is running on the puzzle, 0 otherwise
+  int threshold;                // current cost threshold (IDA*) or deepest explored level (RBFS)
+  int iteration;                // number of thresholds or levels explored so far
+  int f_bound;                  // best proven lower bound of the solution length
+  unsigned long long nodes;     // generated nodes (approximate while running)
+  double elapsed;               // seconds since the solver started (or duration of the last solve)
+};
+int sliding_puzzle_progress_get (Puzzle puzzle, struct sPuzzleProgress *progress);
+
+/** Generate 'count' puzzles at an optimal distance of exactly 'distance' moves from the target, in parallel **/
+/** The puzzles are written one after the other in 'grids', tiles in the order of sliding_puzzle_grid_get, **/
+/** and, if 'nodes' is not null, the number of nodes generated to solve each of them with IDA* (its difficulty). **/
+/** 'model' gives the size, the parity (and so the target) of the puzzles and the databases used to verify them. **/
+/** Returns 'count', or 0 if the puzzles could not be generated: no target of the parity of the model (odd parity **/
+/** on boards of odd height), or no puzzle found after 1000 random walks (e.g. 'distance' close to or beyond the **/
+/** diameter of the puzzle, 31 moves for 3x3, 80 for 4x4). The puzzles are reproducible from **/
+/** sliding_puzzle_random_seed, whatever 'nb_threads'. **/
+int sliding_puzzle_generate (Puzzle model, int distance, int count, int grids[], unsigned long long nodes[],
+                             int nb_threads);
 
 /** Optionally create and share a cycle detection database **/
 void sliding_puzzle_cycle_database_attach (Puzzle puzzle, int cycle_size);
@@ -93,6 +130,64 @@ int sliding_puzzle_cycle_database_share (Puzzle orig, Puzzle dest);
 void sliding_puzzle_heuristic_database_attach (Puzzle puzzle, int pattern_size);
 int sliding_puzzle_heuristic_database_share (Puzzle orig, Puzzle dest);
 
+/** Memory policies of the distance tables of heuristic databases, to be combined with | **/
+/** Tables of hundreds of MB are looked up at random: huge pages cut the TLB misses, and replicas avoid remote accesses **/
+/** on machines with several NUMA nodes. **/
+enum eHeuristicMemoryPolicy
+{
+  SP_MEMORY_DEFAULT = 0,
+  SP_MEMORY_HUGE_PAGES = 1,     // transparent huge pages (see madvise(2), MADV_HUGEPAGE)
+  SP_MEMORY_HUGE_PAGES_RESERVED = 2,    // reserved huge pages (see /proc/sys/vm/nr_hugepages), transparent ones if none are free
+  SP_MEMORY_NUMA_REPLICAS = 4,  // one copy of the tables bound to each NUMA node (see mbind(2)), for its threads
+};
+/** Same as sliding_puzzle_heuristic_database_attach, with the tables allocated following 'policy'. Returns the policy **/
+/** granted by the system, or -1 if no database was attached: reserved huge pages fall back to transparent ones, and **/
+/** these to regular pages; replicas are granted if the tables are copied and bound on every NUMA node. **/
+int sliding_puzzle_heuristic_database_attach_policy (Puzzle puzzle, int pattern_size, int policy);
+
+/** Same as sliding_puzzle_heuristic_database_attach, with the pattern size whose tables fit in 'memory_budget' bytes **/
+/** and give the highest mean distance on 'nb_samples' random grids; no more than the budget is held while choosing. **/
+/** Returns the pattern size (0 if none fits), and the memory of its tables in 'memory' if not null. **/
+int sliding_puzzle_heuristic_database_attach_budget (Puzzle puzzle, size_t memory_budget, int nb_samples,
+                                                     size_t *memory);
+
+/** Patterns of the attached heuristic database, as taken by sliding_puzzle_heuristic_database_attach_groups: **/
+/** returns their number (0 if none), and their sizes and tiles in 'group_sizes' and 'tiles' if not null. **/
+int sliding_puzzle_heuristic_database_groups (Puzzle puzzle, int group_sizes[], int tiles[]);
+
+/** Same as sliding_puzzle_heuristic_database_attach, with 'nb_groups' patterns of 'group_sizes[g]' tiles each, **/
+/** listed one after the other in 'tiles' (numbered as in the target with the empty spot in the upper left corner). **/
+/** The tables are allocated with SP_MEMORY_DEFAULT. Returns 1 once attached, 0 if the groups overlap, miss a tile **/
+/** or have more tiles than the distance tables can index. **/
+int sliding_puzzle_heuristic_database_attach_groups (Puzzle puzzle, int nb_groups, const int group_sizes[],
+                                                     const int tiles[]);
+
+/** Heuristic databases can be shared between processes through a named POSIX shared memory object (see shm_overview(7)) **/
+/** The first process attaching 'name' builds the database in place, the others map it read-only once it is ready **/
+int sliding_puzzle_heuristic_database_attach_shared (Puzzle puzzle, int pattern_size, const char *name);
+int sliding_puzzle_heuristic_database_unlink (const char *name);
+
+/** Optionally attach a complete table of distances to the target, for puzzles of at most 12 tiles (e.g. 3x3, 2x5, 3x4). **/
+/** Solvers then read the solution from the table, without search. The table is loaded from 'filename' if it exists, **/
+/** built otherwise (and saved to 'filename' if not null). It takes (width * height)! / 4 bytes (120 MB for 3x4). **/
+int sliding_puzzle_distance_table_attach (Puzzle puzzle, const char *filename);
+int sliding_puzzle_distance_table_share (Puzzle orig, Puzzle dest);
+
+/** Optionally attach a perimeter: all the states within 'radius' moves of the target, with their exact distance, **/
+/** for puzzles of at most 25 tiles. IDA* stops as soon as it enters the perimeter. The perimeter is kept within **/
+/** 'memory_budget' bytes (17 bytes per state, twice the number of states): returns the radius actually reached. **/
+int sliding_puzzle_perimeter_database_attach (Puzzle puzzle, int radius, size_t memory_budget);
+int sliding_puzzle_perimeter_database_share (Puzzle orig, Puzzle dest);
+
+/** Databases created by *_attach are cached process-wide and reused by later calls with the same parameters. **/
+/** The registry keeps them alive until sliding_puzzle_database_registry_flush: releasing the last puzzle using a **/
+/** database does not free its memory. **/
+void sliding_puzzle_database_registry_flush (void);
+
+/** Optionally replace databases without waiting for running solvers: the next solve picks them up (RCU-like) **/
+int sliding_puzzle_cycle_database_publish (Puzzle orig, Puzzle dest);
+int sliding_puzzle_heuristic_database_publish (Puzzle orig, Puzzle dest);
+
 /*****************************************************
 * FOR UNIT TEST PURPOSES                             *
 *****************************************************/
@@ -0,0 +1,397 @@
+/*
+* Copyright 2018 Laurent Farhi
+* Contact: lfarhi@sfr.fr
+*
+*  This file is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This file is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this file.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Sliding puzzle batch solver.
+// Reads one puzzle per line, e.g. "Korf1 14 13 15 7 11 12 9 5 6 0 2 1 4 8 10 3" (the name is optional, and can be
+// a number as in Korf's lists, "1 14 13 15 7 11 12 9 5 6 0 2 1 4 8 10 3"),
+// and writes one line per puzzle: name, length of the solution, generated nodes, search time and tiles to move.
+// Puzzles flow through a reader -> solvers -> writer pipeline bounded by a window of puzzles in flight,
+// so that memory does not depend on the size of the input.
+// Usage: sp_solve_batch [-j threads] [-w window] [-u] [-r|-b] [-s WxH] [-c cycle_size] [-p pattern_size] [file]
+//   -w: number of puzzles in flight (4 per thread by default)
+//   -u: write solutions as soon as they are found (unordered), instead of in the order of the input
+//   -r: solve with RBFS instead of IDA*
+//   -b: solve with bidirectional IDA* instead of IDA*
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sp_solve.h"
+
+enum eSlotState
+{
+  SLOT_FREE,
+  SLOT_READ,                    // waiting for a solver
+  SLOT_SOLVING,
+  SLOT_SOLVED,                  // waiting for the writer
+};
+
+struct sSlot
+{
+  enum eSlotState state;
+  unsigned long long seq;       // rank of the puzzle in the input
+  unsigned long long line;
+  char *name;
+  int width, height;
+  int grid[257];                // tiles, after the numeric name if any
+  int valid;
+  int length;
+  int *solution;
+  unsigned long long nodes;
+  double elapsed;
+};
+
+static struct
+{
+  int nb_threads;
+  int window;
+  int unordered;
+  int rbfs;
+  int bida;
+  int width, height;            // 0 if the size is deduced from the number of tiles (square puzzles)
+  int cycle_size;
+  int pattern_size;
+  FILE *input;
+
+  // Pipeline
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  struct sSlot *slots;
+  unsigned long long nb_read;   // puzzles read so far
+  unsigned long long nb_written;        // puzzles written so far
+  int eof;
+} batch = {.nb_threads = 0,.window = 0,.cycle_size = 28,.pattern_size = 7,
+  .mutex = PTHREAD_MUTEX_INITIALIZER,.changed = PTHREAD_COND_INITIALIZER
+};
+
+// Parses a line into a slot. Returns 0 for blank lines and comments. Lines with more numbers than the largest puzzle
+// are not valid.
+static int
+line_parse (char *line, struct sSlot *slot)
+{
+  char *p = line;
+  while (isspace ((unsigned char) *p))
+    p++;
+  if (!*p || *p == '#')
+    return 0;
+
+  slot->name = 0;
+  if (!isdigit ((unsigned char) *p))
+  {
+    char *end = p;
+    while (*end && !isspace ((unsigned char) *end))
+      end++;
+    slot->name = strndup (p, end - p);
+    p = end;
+  }
+
+  int nb = 0;
+  char *end;
+  char *index = p;
+  int nb_max = sizeof (slot->grid) / sizeof (*slot->grid);
+  for (long tile; nb < nb_max && (tile = strtol (p, &end, 10), end != p); p = end)
+    slot->grid[nb++] = tile;
+  int overflow = (strtol (p, &end, 10), end != p);
+
+  // One number more than the tiles of the puzzle: the first one is a numeric name (index).
+  int width = batch.width, height = batch.height;
+  if (!width)
+    for (width = height = 1; (width + 1) * (width + 1) <= nb - 1; height = ++width)
+      /* nothing */ ;
+  if (!slot->name && nb > 1 && width * height == nb - 1)
+  {
+    while (isspace ((unsigned char) *index))
+      index++;
+    strtol (index, &end, 10);
+    slot->name = strndup (index, end - index);
+    memmove (slot->grid, slot->grid + 1, --nb * sizeof (*slot->grid));
+  }
+
+  slot->width = batch.width;
+  slot->height = batch.height;
+  if (!slot->width)
+    for (slot->width = slot->height = 1; (slot->width + 1) * (slot->width + 1) <= nb; slot->height = ++slot->width)
+      /* nothing */ ;
+  slot->valid = (!overflow && slot->width * slot->height == nb);
+
+  return 1;
+}
+
+// Returns a slot in state 'state', with the smallest rank, or 0 if none. The mutex is held by the caller.
+static struct sSlot *
+slot_find (enum eSlotState state)
+{
+  struct sSlot *found = 0;
+  for (int i = 0; i < batch.window; i++)
+    if (batch.slots[i].state == state && (!found || batch.slots[i].seq < found->seq))
+      found = &batch.slots[i];
+  return found;
+}
+
+static void *
+reader (void *arg)
+{
+  FILE *input = arg;
+  char *line = 0;
+  size_t size = 0;
+  unsigned long long line_number = 0;
+
+  while (getline (&line, &size, input) >= 0)
+  {
+    line_number++;
+
+    pthread_mutex_lock (&batch.mutex);
+    struct sSlot *slot;
+    // Back-pressure: wait for a slot to be written out.
+    while (!(slot = slot_find (SLOT_FREE)))
+      pthread_cond_wait (&batch.changed, &batch.mutex);
+    pthread_mutex_unlock (&batch.mutex);
+
+    // The slot is owned by the reader until it is marked as read.
+    if (!line_parse (line, slot))
+      continue;
+    slot->line = line_number;
+
+    pthread_mutex_lock (&batch.mutex);
+    slot->state = SLOT_READ;
+    slot->seq = batch.nb_read++;
+    pthread_cond_broadcast (&batch.changed);
+    pthread_mutex_unlock (&batch.mutex);
+  }
+  free (line);
+
+  pthread_mutex_lock (&batch.mutex);
+  batch.eof = 1;
+  pthread_cond_broadcast (&batch.changed);
+  pthread_mutex_unlock (&batch.mutex);
+
+  return 0;
+}
+
+static void
+slot_solve (struct sSlot *slot)
+{
+  slot->length = -1;
+  slot->solution = 0;
+  slot->nodes = 0;
+  slot->elapsed = 0;
+
+  Puzzle puzzle = slot->valid ? sliding_puzzle_init (slot->width, slot->height, slot->grid, 0) : 0;
+  if (!puzzle)
+    return;
+
+  // Databases are built by the first puzzle of each size and found in the registry afterwards.
+  if (batch.cycle_size > 0)
+    sliding_puzzle_cycle_database_attach (puzzle, batch.cycle_size);
+  if (batch.pattern_size > 0)
+    sliding_puzzle_heuristic_database_attach (puzzle, batch.pattern_size);
+
+  slot->length = batch.rbfs ? sliding_puzzle_solve_RBFS (puzzle) :
+    batch.bida ? sliding_puzzle_solve_BIDA (puzzle) : sliding_puzzle_solve_IDA (puzzle);
+  if (slot->length >= 0 && (slot->solution = malloc ((slot->length + 1) * sizeof (*slot->solution))))
+    sliding_puzzle_solution_get (puzzle, slot->solution);
+  else
+    slot->length = -1;
+
+  struct sPuzzleProgress progress;
+  sliding_puzzle_progress_get (puzzle, &progress);
+  slot->nodes = progress.nodes;
+  slot->elapsed = progress.elapsed;
+
+  sliding_puzzle_release (puzzle);
+}
+
+static void *
+solver (void *arg)
+{
+  (void) arg;
+  while (1)
+  {
+    pthread_mutex_lock (&batch.mutex);
+    struct sSlot *slot;
+    // Puzzles are solved in the order of the input.
+    while (!(slot = slot_find (SLOT_READ)) && !batch.eof)
+      pthread_cond_wait (&batch.changed, &batch.mutex);
+    if (!slot)
+    {
+      pthread_mutex_unlock (&batch.mutex);
+      return 0;
+    }
+    slot->state = SLOT_SOLVING;
+    pthread_mutex_unlock (&batch.mutex);
+
+    slot_solve (slot);
+
+    pthread_mutex_lock (&batch.mutex);
+    slot->state = SLOT_SOLVED;
+    pthread_cond_broadcast (&batch.changed);
+    pthread_mutex_unlock (&batch.mutex);
+  }
+}
+
+static void
+slot_write (struct sSlot *slot, FILE * out)
+{
+  if (slot->name)
+    fprintf (out, "%s", slot->name);
+  else
+    fprintf (out, "%llu", slot->line);
+
+  fprintf (out, "\t%i\t%llu\t%.3f\t", slot->length, slot->nodes, slot->elapsed);
+  for (int i = 0; i < slot->length; i++)
+    fprintf (out, i ? " %i" : "%i", slot->solution[i]);
+  fputc ('\n', out);
+
+  free (slot->name);
+  free (slot->solution);
+}
+
+// Writes the solved puzzles, either in the order of the input or as soon as they are solved.
+static void
+writer (FILE * out)
+{
+  int flushed = 1;
+  pthread_mutex_lock (&batch.mutex);
+  while (1)
+  {
+    struct sSlot *slot = slot_find (SLOT_SOLVED);
+    if (slot && !batch.unordered && slot->seq != batch.nb_written)
+      slot = 0;
+
+    if (!slot)
+    {
+      if (batch.eof && batch.nb_written == batch.nb_read)
+        break;
+      // Flush before waiting for solvers, rather than after every line.
+      if (!flushed)
+      {
+        pthread_mutex_unlock (&batch.mutex);
+        fflush (out);
+        pthread_mutex_lock (&batch.mutex);
+        flushed = 1;
+      }
+      else
+        pthread_cond_wait (&batch.changed, &batch.mutex);
+      continue;
+    }
+
+    pthread_mutex_unlock (&batch.mutex);
+    slot_write (slot, out);
+    pthread_mutex_lock (&batch.mutex);
+    flushed = 0;
+
+    slot->state = SLOT_FREE;
+    batch.nb_written++;
+    pthread_cond_broadcast (&batch.changed);
+  }
+  pthread_mutex_unlock (&batch.mutex);
+  fflush (out);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int opt;
+  while ((opt = getopt (argc, argv, "j:w:urbs:c:p:")) != -1)
+    switch (opt)
+    {
+      case 'j':
+        batch.nb_threads = atoi (optarg);
+        break;
+      case 'w':
+        batch.window = atoi (optarg);
+        break;
+      case 'u':
+        batch.unordered = 1;
+        break;
+      case 'r':
+        batch.rbfs = 1;
+        break;
+      case 'b':
+        batch.bida = 1;
+        break;
+      case 's':
+        if (sscanf (optarg, "%ix%i", &batch.width, &batch.height) != 2 || batch.width <= 0 || batch.height <= 0
+            || batch.width * batch.height > 256)
+        {
+          fprintf (stderr, "Invalid size '%s'.\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'c':
+        batch.cycle_size = atoi (optarg);
+        break;
+      case 'p':
+        batch.pattern_size = atoi (optarg);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-j threads] [-w window] [-u] [-r|-b] [-s WxH] [-c cycle_size] [-p pattern_size] [file]\n",
+                 argv[0]);
+        return EXIT_FAILURE;
+    }
+
+  batch.input = stdin;
+  if (optind < argc && !(batch.input = fopen (argv[optind], "r")))
+  {
+    perror (argv[optind]);
+    return EXIT_FAILURE;
+  }
+
+  if (batch.nb_threads <= 0)
+    batch.nb_threads = sysconf (_SC_NPROCESSORS_ONLN) > 0 ? sysconf (_SC_NPROCESSORS_ONLN) : 1;
+  if (batch.window < 0)
+  {
+    fprintf (stderr, "Invalid window %i.\n", batch.window);
+    return EXIT_FAILURE;
+  }
+  else if (!batch.window)
+    batch.window = 4 * batch.nb_threads;
+  else if (batch.window <= batch.nb_threads)
+    fprintf (stderr, "Window %i not larger than the %i threads: solvers will be idle while puzzles are read and written.\n",
+             batch.window, batch.nb_threads);
+
+  pthread_t reader_thread;
+  pthread_t *solver_threads;
+  if (!(batch.slots = calloc (batch.window, sizeof (*batch.slots)))
+      || !(solver_threads = malloc (batch.nb_threads * sizeof (*solver_threads))))
+  {
+    fprintf (stderr, "Memory allocation error.\n");
+    return EXIT_FAILURE;
+  }
+  pthread_create (&reader_thread, 0, reader, batch.input);
+  for (int i = 0; i < batch.nb_threads; i++)
+    pthread_create (&solver_threads[i], 0, solver, 0);
+
+  writer (stdout);
+
+  pthread_join (reader_thread, 0);
+  for (int i = 0; i < batch.nb_threads; i++)
+    pthread_join (solver_threads[i], 0);
+
+  free (solver_threads);
+  free (batch.slots);
+  sliding_puzzle_database_registry_flush ();
+  if (batch.input != stdin)
+    fclose (batch.input);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*
+* Copyright 2018 Laurent Farhi
+* Contact: lfarhi@sfr.fr
+*
+*  This file is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This file is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this file.  If not, see <http://www.gnu.org/licenses/>.
+*/
+// Sliding puzzle solver daemon.
+// The cycle and heuristic databases are built once at start-up, for each supported size of puzzle,
+// and shared with every puzzle received over the socket: the cost of a request is the search only.
+// Usage: sp_solve_daemon [-s socket] [-c cycle_size] [-p pattern_size] [WxH]...   (default size is 4x4)
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "sp_solve.h"
+#include "sp_solve_daemon.h"
+
+#define SIZES_MAX 8
+
+static struct
+{
+  const char *socket;
+  int cycle_size;
+  int pattern_size;
+  int nb_sizes;
+  struct
+  {
+    int width, height;
+    Puzzle warm;                // holds the databases shared with the puzzles of this size
+  } sizes[SIZES_MAX];
+} daemon_config = {.socket = SP_DAEMON_SOCKET,.cycle_size = 28,.pattern_size = 7 };
+
+// Reads exactly 'size' bytes. Returns 0 on end of stream or error.
+static int
+read_full (int fd, void *buf, size_t size)
+{
+  for (size_t done = 0; done < size;)
+  {
+    ssize_t n = read (fd, (char *) buf + done, size - done);
+    if (n == 0 || (n < 0 && errno != EINTR))
+      return 0;
+    if (n > 0)
+      done += n;
+  }
+  return 1;
+}
+
+// Writes exactly 'size' bytes. Returns 0 on error.
+static int
+write_full (int fd, const void *buf, size_t size)
+{
+  for (size_t done = 0; done < size;)
+  {
+    ssize_t n = write (fd, (const char *) buf + done, size - done);
+    if (n < 0 && errno != EINTR)
+      return 0;
+    if (n > 0)
+      done += n;
+  }
+  return 1;
+}
+
+static Puzzle
+warm_puzzle_find (int width, int height)
+{
+  for (int i = 0; i < daemon_config.nb_sizes; i++)
+    if (daemon_config.sizes[i].width == width && daemon_config.sizes[i].height == height)
+      return daemon_config.sizes[i].warm;
+  return 0;
+}
+
+// Solves one request. 'moves' has room for 65535 moves.
+static void
+request_solve (const struct sSolverRequest *request, const uint8_t * tiles, struct sSolverResponse *response,
+               uint8_t * moves)
+{
+  memset (response, 0, sizeof (*response));
+  response->id = request->id;
+
+  Puzzle warm = warm_puzzle_find (request->width, request->height);
+  if (!warm)
+  {
+    response->status = SP_DAEMON_UNSUPPORTED;
+    return;
+  }
+
+  int size = request->width * request->height;
+  int grid[UINT8_MAX];
+  for (int i = 0; i < size; i++)
+    grid[i] = tiles[i];
+
+  Puzzle puzzle = sliding_puzzle_init (request->width, request->height, grid, 0);
+  if (!puzzle)
+  {
+    response->status = SP_DAEMON_INVALID;
+    return;
+  }
+
+  // Databases are shared (reference counted), not copied.
+  sliding_puzzle_cycle_database_share (warm, puzzle);
+  sliding_puzzle_heuristic_database_share (warm, puzzle);
+
+  const char *winner = 0;
+  int length = request->algorithm == SP_DAEMON_RBFS ? sliding_puzzle_solve_RBFS (puzzle) :
+    request->algorithm == SP_DAEMON_BIDA ? sliding_puzzle_solve_BIDA (puzzle) :
+    request->algorithm == SP_DAEMON_PORTFOLIO ? sliding_puzzle_solve_portfolio (puzzle, &winner) :
+    sliding_puzzle_solve_IDA (puzzle);
+  if (winner)
+    fprintf (stderr, "Request %u: %s won.\n", request->id, winner);
+
+  struct sPuzzleProgress progress;
+  sliding_puzzle_progress_get (puzzle, &progress);
+  response->iterations = progress.iteration;
+  response->nodes = progress.nodes;
+  response->nanoseconds = progress.elapsed * 1e9;
+
+  if (length < 0 || length > UINT16_MAX)
+    response->status = SP_DAEMON_FAILED;
+  else
+  {
+    int *solution = malloc ((length + 1) * sizeof (*solution));
+    sliding_puzzle_solution_get (puzzle, solution);
+    for (int i = 0; i < length; i++)
+      moves[i] = solution[i];
+    free (solution);
+    response->status = SP_DAEMON_SOLVED;
+    response->length = length;
+  }
+
+  sliding_puzzle_release (puzzle);
+}
+
+// One thread per connection: requests are read and answered in order, as long as the client keeps sending them.
+static void *
+connection_serve (void *arg)
+{
+  int fd = (int) (intptr_t) arg;
+  struct sSolverRequest request;
+  struct sSolverResponse response;
+  uint8_t tiles[UINT8_MAX * UINT8_MAX];
+  uint8_t *moves = malloc (UINT16_MAX);
+
+  while (read_full (fd, &request, sizeof (request))
+         && read_full (fd, tiles, request.width * request.height))
+  {
+    request_solve (&request, tiles, &response, moves);
+    if (!write_full (fd, &response, sizeof (response)) || !write_full (fd, moves, response.length))
+      break;
+  }
+
+  free (moves);
+  close (fd);
+  return 0;
+}
+
+// Waits for SIGINT or SIGTERM, then removes the socket.
+static void *
+signal_wait (void *arg)
+{
+  sigset_t *set = arg;
+  int sig;
+  sigwait (set, &sig);
+  unlink (daemon_config.socket);
+  fprintf (stderr, "Signal %i received, exiting.\n", sig);
+  exit (EXIT_SUCCESS);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int opt;
+  while ((opt = getopt (argc, argv, "s:c:p:")) != -1)
+    switch (opt)
+    {
+      case 's':
+        daemon_config.socket = optarg;
+        break;
+      case 'c':
+        daemon_config.cycle_size = atoi (optarg);
+        break;
+      case 'p':
+        daemon_config.pattern_size = atoi (optarg);
+        break;
+      default:
+        fprintf (stderr, "Usage: %s [-s socket] [-c cycle_size] [-p pattern_size] [WxH]...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+  for (int i = optind; i < argc && daemon_config.nb_sizes < SIZES_MAX; i++)
+  {
+    int width, height;
+    if (sscanf (argv[i], "%ix%i", &width, &height) != 2 || width <= 0 || height <= 0 || width * height > UINT8_MAX)
+    {
+      fprintf (stderr, "Invalid size '%s'.\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    daemon_config.sizes[daemon_config.nb_sizes].width = width;
+    daemon_config.sizes[daemon_config.nb_sizes].height = height;
+    daemon_config.nb_sizes++;
+  }
+  if (!daemon_config.nb_sizes)
+  {
+    daemon_config.sizes[0].width = daemon_config.sizes[0].height = 4;
+    daemon_config.nb_sizes = 1;
+  }
+
+  // Warm up: build the databases once for all.
+  for (int i = 0; i < daemon_config.nb_sizes; i++)
+  {
+    Puzzle warm = sliding_puzzle_init (daemon_config.sizes[i].width, daemon_config.sizes[i].height, 0, 0);
+    if (!warm)
+      return EXIT_FAILURE;
+    fprintf (stderr, "Loading databases for %ix%i puzzles...\n", daemon_config.sizes[i].width,
+             daemon_config.sizes[i].height);
+    if (daemon_config.cycle_size > 0)
+      sliding_puzzle_cycle_database_attach (warm, daemon_config.cycle_size);
+    if (daemon_config.pattern_size > 0)
+      sliding_puzzle_heuristic_database_attach (warm, daemon_config.pattern_size);
+    daemon_config.sizes[i].warm = warm;
+  }
+
+  // Signals are handled by a dedicated thread; a client closing its connection early must not kill the daemon.
+  sigset_t set;
+  sigemptyset (&set);
+  sigaddset (&set, SIGINT);
+  sigaddset (&set, SIGTERM);
+  pthread_sigmask (SIG_BLOCK, &set, 0);
+  signal (SIGPIPE, SIG_IGN);
+
+  struct sockaddr_un addr = {.sun_family = AF_UNIX };
+  if (strlen (daemon_config.socket) >= sizeof (addr.sun_path))
+  {
+    fprintf (stderr, "Socket path too long.\n");
+    return EXIT_FAILURE;
+  }
+  strcpy (addr.sun_path, daemon_config.socket);
+
+  int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+  unlink (daemon_config.socket);
+  if (listener < 0 || bind (listener, (struct sockaddr *) &addr, sizeof (addr)) || listen (listener, SOMAXCONN))
+  {
+    perror (daemon_config.socket);
+    return EXIT_FAILURE;
+  }
+
+  pthread_t signal_thread;
+  pthread_create (&signal_thread, 0, signal_wait, &set);
+
+  fprintf (stderr, "Listening on %s.\n", daemon_config.socket);
+  while (1)
+  {
+    int fd = accept (listener, 0, 0);
+    if (fd < 0)
+    {
+      if (errno != EINTR && errno != ECONNABORTED)
+        perror ("accept");
+      continue;
+    }
+
+    pthread_t thread;
+    if (pthread_create (&thread, 0, connection_serve, (void *) (intptr_t) fd))
+      close (fd);
+    else
+      pthread_detach (thread);
+  }
+}
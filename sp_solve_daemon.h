@@ -0,0 +1,73 @@
+/*
+* Copyright 2018 Laurent Farhi
+* Contact: lfarhi@sfr.fr
+*
+*  This file is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  This file is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this file.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#ifndef SP_SOLVE_DAEMON_H
+#  define SP_SOLVE_DAEMON_H
+
+#  include <stdint.h>
+
+/*
+ * Sliding puzzle solver daemon: protocol
+ */
+
+/********************************
+- Local (Unix domain) stream socket: integers are in host byte order.
+- A client may send any number of requests without waiting for the responses (pipelining).
+- Responses are sent back on the same connection, in the order of the requests.
+********************************/
+
+#  define SP_DAEMON_SOCKET "/tmp/sp_solve.sock"
+
+enum eSolverAlgorithm
+{
+  SP_DAEMON_IDA = 0,
+  SP_DAEMON_RBFS = 1,
+  SP_DAEMON_BIDA = 2,
+  SP_DAEMON_PORTFOLIO = 3,      // IDA* and RBFS, with and without cycle detection, raced on the same puzzle
+};
+
+enum eSolverStatus
+{
+  SP_DAEMON_SOLVED = 0,         // the response holds an optimal sequence of moves
+  SP_DAEMON_INVALID = 1,        // the grid is not a valid puzzle
+  SP_DAEMON_UNSUPPORTED = 2,    // no database was loaded for this size of puzzle
+  SP_DAEMON_FAILED = 3,         // the puzzle could not be solved
+};
+
+/** Request, followed by 'width * height' bytes: the tiles of the grid, row by row (0 is the empty spot) **/
+struct sSolverRequest
+{
+  uint32_t id;                  // echoed in the response
+  uint8_t width, height;
+  uint8_t algorithm;            // enum eSolverAlgorithm
+  uint8_t reserved;
+};
+
+/** Response, followed by 'length' bytes: the tiles to move, in order **/
+struct sSolverResponse
+{
+  uint32_t id;
+  uint8_t status;               // enum eSolverStatus
+  uint8_t reserved;
+  uint16_t length;              // number of moves of the solution
+  uint32_t iterations;          // thresholds (IDA*) or levels (RBFS) explored
+  uint64_t nodes;               // generated nodes
+  uint64_t nanoseconds;         // search duration
+};
+
+#endif
@@ -20,8 +20,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "sp_solve.h"
+#include "sp_solve_daemon.h"
 
 static void
 solution_shower (Puzzle puzzle, int move, int tile, int direction)
@@ -36,12 +46,1005 @@ solution_shower (Puzzle puzzle, int move, int tile, int direction)
   printf (" %2i: %2i(%c)\n", move, tile, direction ? direction : '0');
 }
 
+// Replays the 'length' moves (tiles to move) on 'grid': returns 0 if they are legal and lead to the target
+// (the empty spot in the upper left corner, or in the lower right corner for grids of odd parity).
+static int
+solution_replay (int width, int height, const int grid[], int length, const int moves[])
+{
+  int size = width * height;
+  int g[size];
+  int parity = 0;
+  for (int pos = 0; pos < size; pos++)
+  {
+    g[pos] = grid[pos];
+    if (!grid[pos])
+      parity += pos / width;
+    for (int next = pos + 1; next < size; next++)
+      if (grid[pos] && grid[next] && grid[pos] > grid[next])
+        parity++;
+  }
+
+  int blank = 0;
+  while (blank < size && grid[blank])
+    blank++;
+  if (blank == size)
+    return -1;
+  for (int i = 0; i < length; i++)
+  {
+    int pos = 0;
+    while (pos < size && g[pos] != moves[i])
+      pos++;
+    if (pos == size || !moves[i]
+        || !((pos == blank - width || pos == blank + width) || (pos / width == blank / width && abs (pos - blank) == 1)))
+      return -1;
+    g[blank] = g[pos];
+    g[pos] = 0;
+    blank = pos;
+  }
+
+  for (int pos = 0; pos < size; pos++)
+    if (g[pos] != (parity % 2 ? (pos + 1) % size : pos))
+      return -1;
+
+  return 0;
+}
+
+// Replays the solution found for 'puzzle' on its grid.
+static int
+sliding_puzzle_replay (Puzzle puzzle, int width, int height, int length)
+{
+  int grid[width * height];
+  int moves[length + 1];
+  sliding_puzzle_grid_get (puzzle, grid);
+  sliding_puzzle_solution_get (puzzle, moves);
+
+  return solution_replay (width, height, grid, length, moves);
+}
+
+// Puzzles of odd parity and non-square boards, solved by the tests of the solvers and databases.
+static const struct sTestCase
+{
+  int width, height;
+  int grid[12];
+  int length;                   // optimal
+} test_cases[] = {
+  {3, 3, {5, 2, 6, 3, 1, 0, 7, 4, 8}, 19},      // odd parity
+  {3, 4, {2, 3, 6, 1, 7, 5, 10, 9, 8, 0, 4, 11}, 24},   // odd parity, the empty spot in a corner
+  {4, 3, {1, 4, 0, 7, 5, 9, 3, 2, 10, 8, 6, 11}, 24},
+  {3, 4, {1, 5, 4, 3, 8, 2, 7, 0, 10, 9, 11, 6}, 23},
+};
+
+enum
+{ NB_TEST_CASES = sizeof (test_cases) / sizeof (*test_cases) };
+
+static Puzzle
+test_case_init (const struct sTestCase *test_case)
+{
+  int grid[sizeof (test_case->grid) / sizeof (*test_case->grid)];
+  memcpy (grid, test_case->grid, sizeof (grid));
+
+  return sliding_puzzle_init (test_case->width, test_case->height, grid, 0);
+}
+
+// Solves 'puzzle', initialized from 'test_case', with 'solver' and replays the solution: returns 0 if it is optimal
+// and leads to the target.
+static int
+test_case_solve (Puzzle puzzle, const struct sTestCase *test_case, int (*solver) (Puzzle))
+{
+  if (solver (puzzle) != test_case->length)
+    return -1;
+
+  return sliding_puzzle_replay (puzzle, test_case->width, test_case->height, test_case->length);
+}
+
+struct ShareBenchmark
+{
+  Puzzle shared;
+  int nbShares;
+  int failed;
+};
+
+static void *
+share_benchmark_worker (void *arg)
+{
+  struct ShareBenchmark *b = arg;
+  Puzzle puzzle = sliding_puzzle_init (4, 4, 0, 0);
+
+  // Every call takes a read lock on the shared puzzle and a write lock on the private one.
+  for (int i = 0; i < b->nbShares; i++)
+  {
+    int h = sliding_puzzle_heuristic_database_share (b->shared, puzzle);
+    int c = sliding_puzzle_cycle_database_share (b->shared, puzzle);
+    // Databases are actually shared by the first call only, later calls find them already shared.
+    if (i == 0 && !(h && c))
+      b->failed = 1;
+  }
+
+  sliding_puzzle_release (puzzle);
+  return 0;
+}
+
+// The first puzzle builds the heuristic database in shared memory, the second one maps it.
+static int
+sliding_puzzle_shared_database_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };
+  char name[64];
+  snprintf (name, sizeof (name), "/sp_solve_test.%ld", (long) getpid ());
+
+  int ret = 0;
+  Puzzle builder = sliding_puzzle_init (3, 3, grid, 0);
+  Puzzle reader = sliding_puzzle_init (3, 3, grid, 0);
+  if (!sliding_puzzle_heuristic_database_attach_shared (builder, 3, name)
+      || !sliding_puzzle_heuristic_database_attach_shared (reader, 3, name)
+      || sliding_puzzle_solve_IDA (builder) != sliding_puzzle_solve_IDA (reader)
+      || !sliding_puzzle_heuristic_database_unlink (name))
+    ret = -1;
+  sliding_puzzle_release (builder);
+  sliding_puzzle_release (reader);
+
+  // A builder killed before the tables are ready: the reader gives up instead of waiting forever.
+  pid_t pid = fork ();
+  if (pid == 0)
+  {
+    Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+    sliding_puzzle_heuristic_database_attach_shared (p, 8, name);
+    _exit (EXIT_SUCCESS);
+  }
+  struct timespec period = {.tv_sec = 0,.tv_nsec = 1000000 };
+  int fd;
+  struct stat st;
+  while ((fd = shm_open (name, O_RDONLY, 0)) < 0 || fstat (fd, &st) || !st.st_size)
+  {
+    if (fd >= 0)
+      close (fd);
+    nanosleep (&period, 0);
+  }
+  close (fd);
+  kill (pid, SIGKILL);
+  waitpid (pid, 0, 0);
+  reader = sliding_puzzle_init (3, 3, grid, 0);
+  if (sliding_puzzle_heuristic_database_attach_shared (reader, 8, name) || !sliding_puzzle_heuristic_database_unlink (name))
+    ret = -1;
+  sliding_puzzle_release (reader);
+
+  return ret;
+}
+
+static void *
+progress_solver (void *arg)
+{
+  sliding_puzzle_solve_IDA (arg);
+  return 0;
+}
+
+// The progress of a solver is read from another thread while it runs: the solver is running and its generated nodes
+// grow. The solve (Korf's puzzle 1, 57 moves, with Manhattan distance only) is cancelled once this is seen.
+static int
+sliding_puzzle_progress_test ()
+{
+  int grid[] = { 14, 13, 15, 7, 11, 12, 9, 5, 6, 0, 2, 1, 4, 8, 10, 3 };
+
+  Puzzle p = sliding_puzzle_init (4, 4, grid, 0);
+  pthread_t thread;
+  pthread_create (&thread, 0, progress_solver, p);
+
+  struct timespec period = {.tv_sec = 0,.tv_nsec = 10000000 };
+  struct sPuzzleProgress progress;
+  unsigned long long nodes = 0;
+  int increases = 0;
+  for (int i = 0; i < 1000 && increases < 3; i++)
+  {
+    nanosleep (&period, 0);
+    if (sliding_puzzle_progress_get (p, &progress) && progress.running && progress.nodes > nodes)
+    {
+      if (nodes)
+        increases++;
+      nodes = progress.nodes;
+    }
+  }
+  pthread_cancel (thread);
+  pthread_join (thread, 0);
+
+  int ret = increases == 3 && sliding_puzzle_progress_get (p, &progress) && !progress.running ? 0 : -1;
+  sliding_puzzle_release (p);
+
+  return ret;
+}
+
+// A published database is picked up by the next solve, after which it is the database of both puzzles.
+static int
+sliding_puzzle_publish_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+
+  Puzzle orig = sliding_puzzle_init (3, 3, grid, 0);
+  Puzzle dest = sliding_puzzle_init (3, 3, grid, 0);
+  sliding_puzzle_heuristic_database_attach (orig, 4);
+  sliding_puzzle_cycle_database_attach (orig, 6);
+  int ret = sliding_puzzle_heuristic_database_publish (orig, dest) && sliding_puzzle_cycle_database_publish (orig, dest)
+    && sliding_puzzle_solve_IDA (dest) == 27
+    && !sliding_puzzle_heuristic_database_share (orig, dest) && !sliding_puzzle_cycle_database_share (orig, dest) ? 0 : -1;
+  sliding_puzzle_release (orig);
+  sliding_puzzle_release (dest);
+
+  return ret;
+}
+
+// Databases built by attach are found in the registry by later attach calls, until the registry is flushed.
+static int
+sliding_puzzle_registry_test ()
+{
+  Puzzle p = sliding_puzzle_init (3, 3, 0, 0);
+  Puzzle q = sliding_puzzle_init (3, 3, 0, 0);
+  Puzzle r = sliding_puzzle_init (3, 3, 0, 0);
+  sliding_puzzle_heuristic_database_attach (p, 4);
+  sliding_puzzle_cycle_database_attach (p, 6);
+  sliding_puzzle_heuristic_database_attach (q, 4);
+  sliding_puzzle_cycle_database_attach (q, 6);
+  // Sharing the same databases again is a no-op.
+  int ret = !sliding_puzzle_heuristic_database_share (p, q) && !sliding_puzzle_cycle_database_share (p, q) ? 0 : -1;
+
+  sliding_puzzle_database_registry_flush ();
+  sliding_puzzle_heuristic_database_attach (r, 4);
+  sliding_puzzle_cycle_database_attach (r, 6);
+  if (!sliding_puzzle_heuristic_database_share (p, r) || !sliding_puzzle_cycle_database_share (p, r))
+    ret = -1;
+
+  sliding_puzzle_release (p);
+  sliding_puzzle_release (q);
+  sliding_puzzle_release (r);
+
+  return ret;
+}
+
+// Puzzles generated at a prescribed optimal distance, of the parity of the model.
+static int
+sliding_puzzle_generate_test ()
+{
+  enum { COUNT = 8 };
+  struct
+  {
+    int width, height;
+    int grid[16];               // model
+    int distance;
+    int count;                  // expected return
+  } cases[] = {
+    {3, 3, {0, 1, 2, 3, 4, 5, 6, 7, 8}, 20, COUNT},
+    {3, 3, {0, 1, 2, 3, 4, 5, 6, 7, 8}, 21, COUNT},
+    {4, 3, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, 17, COUNT},
+    {3, 4, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, 18, COUNT},
+    {4, 4, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0}, 15, COUNT},  // odd parity
+    {3, 3, {3, 1, 2, 0, 4, 5, 6, 7, 8}, 20, 0}, // odd parity, no target on a board of odd height
+    {3, 3, {0, 1, 2, 3, 4, 5, 6, 7, 8}, 32, 0}, // beyond the diameter
+  };
+  int ret = 0;
+
+  for (size_t c = 0; !ret && c < sizeof (cases) / sizeof (*cases); c++)
+  {
+    int width = cases[c].width, height = cases[c].height;
+    int grids[COUNT][16];
+    unsigned long long nodes[COUNT];
+
+    Puzzle model = sliding_puzzle_init (width, height, cases[c].grid, 0);
+    sliding_puzzle_heuristic_database_attach (model, 3);
+    if (sliding_puzzle_generate (model, cases[c].distance, COUNT, &grids[0][0], nodes, 4) != cases[c].count)
+      ret = -1;
+    for (int i = 0; !ret && i < cases[c].count; i++)
+    {
+      Puzzle p = sliding_puzzle_init (width, height, grids[0] + i * width * height, 0);
+      if (sliding_puzzle_parity_get (p) != sliding_puzzle_parity_get (model)
+          || sliding_puzzle_solve_RBFS (p) != cases[c].distance
+          || sliding_puzzle_replay (p, width, height, cases[c].distance))
+        ret = -1;
+      sliding_puzzle_release (p);
+    }
+    sliding_puzzle_release (model);
+  }
+
+  // Puzzles generated concurrently are reproducible from a seed, whatever the number of threads.
+  int seeded[2][COUNT][9];
+  Puzzle model = sliding_puzzle_init (3, 3, cases[0].grid, 0);
+  sliding_puzzle_heuristic_database_attach (model, 3);
+  for (int i = 0; !ret && i < 2; i++)
+  {
+    sliding_puzzle_random_seed (2018);
+    if (sliding_puzzle_generate (model, 20, COUNT, &seeded[i][0][0], 0, i ? 2 : 4) != COUNT)
+      ret = -1;
+  }
+  if (!ret && memcmp (seeded[0], seeded[1], sizeof (seeded[0])))
+    ret = -1;
+  sliding_puzzle_release (model);
+
+  // Walks on 3x3 go through puzzles of odd parity, whose center tile is numbered by central symmetry as well.
+  int odd[] = { 5, 2, 6, 3, 1, 0, 7, 4, 8 };    // 19 moves
+  Puzzle p = sliding_puzzle_init (3, 3, odd, 0);
+  sliding_puzzle_heuristic_database_attach (p, 3);
+  if (sliding_puzzle_parity_get (p) != 1 || sliding_puzzle_solve_IDA (p) != 19 || sliding_puzzle_replay (p, 3, 3, 19))
+    ret = -1;
+  sliding_puzzle_release (p);
+
+  return ret;
+}
+
+// Complete distance table: built and saved, then loaded from the file.
+static int
+sliding_puzzle_distance_table_test ()
+{
+  const struct sTestCase cases[] = {
+    {3, 3, {8, 6, 7, 2, 5, 4, 3, 0, 1}, 27},
+    {5, 2, {9, 8, 7, 6, 5, 4, 3, 2, 1, 0}, 44},
+    {2, 5, {6, 1, 3, 0, 2, 7, 8, 5, 4, 9}, 30},
+  };
+  enum
+  { NB_CASES = sizeof (cases) / sizeof (*cases) };
+  char filename[64];
+  snprintf (filename, sizeof (filename), "/tmp/sp_solve_test.%ld.spdt", (long) getpid ());
+
+  int ret = 0;
+  for (int c = 0; !ret && c < NB_CASES + NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = c < NB_CASES ? &cases[c] : &test_cases[c - NB_CASES];
+    // Tables of 12 tiles take minutes to build.
+    if (test_case->width * test_case->height > 10)
+      continue;
+
+    for (int i = 0; !ret && i < 2; i++)
+    {
+      Puzzle p = test_case_init (test_case);
+      if (!sliding_puzzle_distance_table_attach (p, filename)
+          || test_case_solve (p, test_case, sliding_puzzle_solve_IDA)
+          || test_case_solve (p, test_case, sliding_puzzle_solve_RBFS))
+        ret = -1;
+      sliding_puzzle_release (p);
+      // Forget the table built, so that it is loaded from the file.
+      sliding_puzzle_database_registry_flush ();
+    }
+    remove (filename);
+  }
+
+  // Boards of more than 12 tiles have no table.
+  Puzzle p = sliding_puzzle_init (4, 4, 0, 0);
+  if (sliding_puzzle_distance_table_attach (p, 0))
+    ret = -1;
+  sliding_puzzle_release (p);
+
+  return ret;
+}
+
+static int
+sliding_puzzle_perimeter_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  Puzzle q = sliding_puzzle_init (3, 3, grid, 0);
+  // 3x3 puzzles have 181440 states: a radius of 31 would be the whole puzzle, the budget stops the search before.
+  int radius = sliding_puzzle_perimeter_database_attach (p, 31, 1 << 20);
+  sliding_puzzle_perimeter_database_share (p, q);
+  int ret = radius > 0 && radius < 31 && sliding_puzzle_solve_IDA (p) == 27 && !sliding_puzzle_replay (p, 3, 3, 27)
+    && sliding_puzzle_solve_IDA (q) == 27 ? 0 : -1;
+
+  // The registry holds one perimeter per memory budget: a larger one reaches further, the same one is reused.
+  Puzzle r = sliding_puzzle_init (3, 3, grid, 0);
+  if (sliding_puzzle_perimeter_database_attach (r, 31, 64 << 20) <= radius || sliding_puzzle_solve_IDA (r) != 27
+      || sliding_puzzle_replay (r, 3, 3, 27)
+      || sliding_puzzle_perimeter_database_attach (q, 31, 1 << 20) != radius
+      || sliding_puzzle_perimeter_database_share (p, q) || !sliding_puzzle_perimeter_database_share (r, q))
+    ret = -1;
+  sliding_puzzle_release (p);
+  sliding_puzzle_release (q);
+  sliding_puzzle_release (r);
+
+  // Odd parity, and non-square boards.
+  for (int c = 0; !ret && c < NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = &test_cases[c];
+    p = test_case_init (test_case);
+    if (sliding_puzzle_perimeter_database_attach (p, 8, 1 << 20) <= 0
+        || test_case_solve (p, test_case, sliding_puzzle_solve_IDA))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+
+  return ret;
+}
+
+// On boards of a power of 2 cells, the distance tables are reordered in place (Morton order): the heuristic must stay
+// admissible for patterns of any size, and of both parities.
+static int
+sliding_puzzle_table_layout_test ()
+{
+  struct
+  {
+    int width, height;
+    int grid[16];
+  } cases[] = {
+    {4, 2, {5, 4, 0, 6, 7, 3, 2, 1}},
+    {2, 4, {5, 4, 3, 2, 0, 1, 7, 6}},
+    {8, 2, {1, 2, 9, 11, 4, 5, 14, 8, 10, 0, 12, 3, 13, 7, 6, 15}},
+  };
+  int ret = 0;
+  for (size_t c = 0; !ret && c < sizeof (cases) / sizeof (*cases); c++)
+    for (int pattern_size = 2; !ret && pattern_size <= 4; pattern_size++)
+    {
+      int width = cases[c].width, height = cases[c].height;
+      Puzzle p = sliding_puzzle_init (width, height, cases[c].grid, 0);
+      Puzzle q = sliding_puzzle_init (width, height, cases[c].grid, 0);
+      sliding_puzzle_heuristic_database_attach (p, pattern_size);
+      int length = sliding_puzzle_solve_IDA (q);
+      if (length < 0 || sliding_puzzle_solve_IDA (p) != length || sliding_puzzle_replay (p, width, height, length))
+        ret = -1;
+      sliding_puzzle_release (p);
+      sliding_puzzle_release (q);
+    }
+
+  return ret;
+}
+
+// Nodes hold one byte per cell up to 256 cells, two beyond: boards on both sides of the limit, a few moves from target.
+static int
+sliding_puzzle_node_layout_test ()
+{
+  int sizes[][2] = { {16, 16}, {17, 16}, {3, 100} };
+  int ret = 0;
+  for (size_t c = 0; !ret && c < sizeof (sizes) / sizeof (*sizes); c++)
+  {
+    int width = sizes[c][0], height = sizes[c][1];
+    int *grid = malloc (width * height * sizeof (*grid));
+    for (int pos = 0; pos < width * height; pos++)
+      grid[pos] = pos;
+    // The blank walks right, down, right, down from the upper left corner: 4 moves away from the target of even parity
+    // (an even number of vertical moves keeps the parity of boards of odd width).
+    int blank = 0;
+    int walk[] = { 1, width, 1, width };
+    for (size_t i = 0; i < sizeof (walk) / sizeof (*walk); i++)
+    {
+      grid[blank] = grid[blank + walk[i]];
+      grid[blank + walk[i]] = 0;
+      blank += walk[i];
+    }
+
+    Puzzle p = sliding_puzzle_init (width, height, grid, 0);
+    if (!p || sliding_puzzle_solve_IDA (p) != 4 || sliding_puzzle_replay (p, width, height, 4)
+        || sliding_puzzle_solve_RBFS (p) != 4 || sliding_puzzle_replay (p, width, height, 4))
+      ret = -1;
+    sliding_puzzle_release (p);
+    free (grid);
+  }
+
+  return ret;
+}
+
+// Bidirectional IDA* finds the optimal solutions of IDA*, and attaches nothing to the puzzle.
+static int
+sliding_puzzle_bidirectional_test ()
+{
+  struct
+  {
+    int width, height;
+    int grid[16];
+    int database;               // pattern size of the heuristic database, none if 0
+  } cases[] = {
+    {3, 3, {0, 1, 2, 3, 4, 5, 6, 7, 8}, 0},     // solved
+    {3, 3, {8, 6, 7, 2, 5, 4, 3, 0, 1}, 0},     // 27 moves
+    {4, 4, {4, 6, 0, 3, 5, 2, 7, 10, 12, 14, 1, 15, 13, 9, 11, 8}, 0},
+    {4, 4, {5, 1, 3, 4, 14, 6, 7, 11, 0, 15, 2, 10, 9, 13, 12, 8}, 2},   // odd parity
+  };
+  int ret = 0;
+  for (size_t c = 0; !ret && c < sizeof (cases) / sizeof (*cases); c++)
+  {
+    int width = cases[c].width, height = cases[c].height;
+    Puzzle p = sliding_puzzle_init (width, height, cases[c].grid, 0);
+    Puzzle q = sliding_puzzle_init (width, height, cases[c].grid, 0);
+    if (cases[c].database)
+      sliding_puzzle_heuristic_database_attach (p, cases[c].database);
+    int length = sliding_puzzle_solve_IDA (q);
+    if (length < 0 || sliding_puzzle_solve_BIDA (p) != length || sliding_puzzle_replay (p, width, height, length)
+        || sliding_puzzle_perimeter_database_share (p, q))
+      ret = -1;
+    sliding_puzzle_release (p);
+    sliding_puzzle_release (q);
+  }
+
+  // Odd parity, and non-square boards, with and without a heuristic database.
+  for (int c = 0; !ret && c < 2 * NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = &test_cases[c / 2];
+    Puzzle p = test_case_init (test_case);
+    if (c % 2)
+      sliding_puzzle_heuristic_database_attach (p, 2);
+    if (test_case_solve (p, test_case, sliding_puzzle_solve_BIDA))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+
+  return ret;
+}
+
+// Heuristic tables on huge pages (reserved ones, or transparent ones if none are free), and copied on every NUMA node.
+static int
+sliding_puzzle_memory_policy_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+
+  // Reserved huge pages fall back to transparent ones, then to regular pages. A machine of one NUMA node has no replicas.
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  int policy =
+    sliding_puzzle_heuristic_database_attach_policy (p, 3, SP_MEMORY_HUGE_PAGES_RESERVED | SP_MEMORY_NUMA_REPLICAS);
+  int ret = policy >= 0 && !(policy & ~(SP_MEMORY_HUGE_PAGES | SP_MEMORY_HUGE_PAGES_RESERVED | SP_MEMORY_NUMA_REPLICAS))
+    && ((policy & SP_MEMORY_HUGE_PAGES) == 0 || (policy & SP_MEMORY_HUGE_PAGES_RESERVED) == 0)
+    && (!access ("/sys/devices/system/node/node1", F_OK) || !(policy & SP_MEMORY_NUMA_REPLICAS))
+    && sliding_puzzle_solve_IDA (p) == 27 && sliding_puzzle_solve_RBFS (p) == 27 ? 0 : -1;
+  sliding_puzzle_threads_set (p, 4);
+  if (sliding_puzzle_solve_IDA (p) != 27 || sliding_puzzle_solve_RBFS (p) != 27)
+    ret = -1;
+  // The registry gives the same tables, hence the same policy.
+  Puzzle q = sliding_puzzle_init (3, 3, grid, 0);
+  if (sliding_puzzle_heuristic_database_attach_policy (q, 3, SP_MEMORY_HUGE_PAGES_RESERVED | SP_MEMORY_NUMA_REPLICAS)
+      != policy)
+    ret = -1;
+  sliding_puzzle_release (p);
+  sliding_puzzle_release (q);
+
+  // Transparent huge pages, if the kernel has them enabled, on a non-square board; no policy at all; bad arguments.
+  char enabled[64] = "";
+  FILE *f = fopen ("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (f)
+  {
+    if (!fgets (enabled, sizeof (enabled), f))
+      *enabled = 0;
+    fclose (f);
+  }
+  int tall[] = { 1, 5, 4, 3, 8, 2, 7, 0, 10, 9, 11, 6 };       // 23 moves
+  p = sliding_puzzle_init (3, 4, tall, 0);
+  policy = sliding_puzzle_heuristic_database_attach_policy (p, 3, SP_MEMORY_HUGE_PAGES);
+  if (policy < 0 || (policy & ~SP_MEMORY_HUGE_PAGES)
+      || (*enabled && policy != (strstr (enabled, "[never]") ? SP_MEMORY_DEFAULT : SP_MEMORY_HUGE_PAGES))
+      || sliding_puzzle_solve_IDA (p) != 23 || sliding_puzzle_replay (p, 3, 4, 23)
+      || sliding_puzzle_heuristic_database_attach_policy (p, 3, SP_MEMORY_DEFAULT) != SP_MEMORY_DEFAULT
+      || sliding_puzzle_solve_RBFS (p) != 23 || sliding_puzzle_replay (p, 3, 4, 23)
+      || sliding_puzzle_heuristic_database_attach_policy (p, 3, 8) != -1
+      || sliding_puzzle_heuristic_database_attach_policy (p, 0, SP_MEMORY_HUGE_PAGES) != -1)
+    ret = -1;
+  sliding_puzzle_release (p);
+
+  return ret;
+}
+
+static int
+sliding_puzzle_memory_budget_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+  size_t memory = 0;
+
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  int ret = sliding_puzzle_heuristic_database_attach_budget (p, 10, 100, &memory) == 0 ? 0 : -1;
+  // Nothing fits: nothing is attached, and 'memory' is left as is.
+  if (sliding_puzzle_heuristic_database_attach_budget (p, 0, 100, &memory) || memory
+      || sliding_puzzle_heuristic_database_groups (p, 0, 0) || sliding_puzzle_heuristic_database_attach_budget (p, 1, 0, 0))
+    ret = -1;
+  // 8 patterns of 1 tile (9 entries each) fit exactly in 72 bytes, not in 71.
+  if (sliding_puzzle_heuristic_database_attach_budget (p, 71, 100, &memory)
+      || sliding_puzzle_heuristic_database_attach_budget (p, 72, 100, &memory) != 1 || memory != 72
+      || sliding_puzzle_heuristic_database_groups (p, 0, 0) != 8)
+    ret = -1;
+  // 2 patterns of 4 tiles (9^4 entries each) at most.
+  int pattern_size = sliding_puzzle_heuristic_database_attach_budget (p, 2 * 6561, 1000, &memory);
+  if (pattern_size <= 0 || memory > 2 * 6561 || sliding_puzzle_solve_IDA (p) != 27)
+    ret = -1;
+
+  // The chosen patterns cover the tiles once, and can be attached as user-defined patterns.
+  int sizes[8], tiles[8], covered[9] = { 0 };
+  int nb_groups = sliding_puzzle_heuristic_database_groups (p, sizes, tiles);
+  for (int g = 0, t = 0; g < nb_groups; g++)
+    for (int i = 0; i < sizes[g]; i++, t++)
+      if (sizes[g] > pattern_size || t >= 8 || tiles[t] <= 0 || tiles[t] > 8 || covered[tiles[t]]++)
+        ret = -1;
+  Puzzle q = sliding_puzzle_init (3, 3, grid, 0);
+  if (nb_groups <= 0 || !sliding_puzzle_heuristic_database_attach_groups (q, nb_groups, sizes, tiles)
+      || sliding_puzzle_heuristic_database_groups (q, 0, 0) != nb_groups || sliding_puzzle_solve_RBFS (q) != 27
+      || sliding_puzzle_replay (q, 3, 3, 27))
+    ret = -1;
+  sliding_puzzle_release (p);
+  sliding_puzzle_release (q);
+
+  // Odd parity, and non-square boards.
+  for (int c = 0; !ret && c < NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = &test_cases[c];
+    p = test_case_init (test_case);
+    if (sliding_puzzle_heuristic_database_attach_budget (p, 1 << 20, 100, &memory) <= 0 || memory > 1 << 20
+        || test_case_solve (p, test_case, sliding_puzzle_solve_IDA))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+
+  return ret;
+}
+
+static int
+sliding_puzzle_pattern_groups_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+  int sizes[] = { 3, 5 };
+  int groups[] = { 1, 2, 5, 3, 4, 6, 7, 8 };
+  int overlapping[] = { 1, 2, 5, 3, 4, 5, 7, 8 };
+  int blank[] = { 0, 2, 5, 3, 4, 6, 7, 8 };
+  int outside[] = { 1, 2, 9, 3, 4, 6, 7, 8 };
+  int too_many[] = { 3, 6 };
+  int empty[] = { 0, 8 };
+
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  int ret = !sliding_puzzle_heuristic_database_attach_groups (p, 2, sizes, overlapping)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 2, sizes, blank)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 2, sizes, outside)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 1, sizes, groups)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 2, too_many, groups)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 2, empty, groups)
+    && !sliding_puzzle_heuristic_database_attach_groups (p, 0, sizes, groups)
+    && !sliding_puzzle_heuristic_database_groups (p, 0, 0)
+    && sliding_puzzle_heuristic_database_attach_groups (p, 2, sizes, groups) && sliding_puzzle_solve_IDA (p) == 27
+    && !sliding_puzzle_replay (p, 3, 3, 27) && sliding_puzzle_solve_RBFS (p) == 27
+    && !sliding_puzzle_replay (p, 3, 3, 27) ? 0 : -1;
+  sliding_puzzle_release (p);
+
+  // Patterns larger than the distance tables can index (4 tiles on 16x16) are rejected before anything is built.
+  int *large = malloc (16 * 16 * sizeof (*large));
+  for (int pos = 0; pos < 16 * 16; pos++)
+    large[pos] = pos;
+  int large_sizes[] = { 5, 250 };
+  p = sliding_puzzle_init (16, 16, large, 0);
+  if (ret || sliding_puzzle_heuristic_database_attach_groups (p, 2, large_sizes, large + 1))
+    ret = -1;
+  sliding_puzzle_release (p);
+  free (large);
+
+  // Non-contiguous patterns (odd tiles, then even tiles) on odd parity, and non-square boards.
+  for (int c = 0; !ret && c < NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = &test_cases[c];
+    int size = test_case->width * test_case->height;
+    int odd_even_sizes[2] = { size / 2, (size - 1) / 2 };
+    int odd_even[11], nb_tiles = 0;
+    for (int first = 1; first <= 2; first++)
+      for (int tile = first; tile < size; tile += 2)
+        odd_even[nb_tiles++] = tile;
+    p = test_case_init (test_case);
+    int group_sizes[2], tiles[11];
+    if (!sliding_puzzle_heuristic_database_attach_groups (p, 2, odd_even_sizes, odd_even)
+        || sliding_puzzle_heuristic_database_groups (p, group_sizes, tiles) != 2
+        || memcmp (group_sizes, odd_even_sizes, sizeof (group_sizes))
+        || memcmp (tiles, odd_even, nb_tiles * sizeof (*tiles))
+        || test_case_solve (p, test_case, sliding_puzzle_solve_IDA)
+        || test_case_solve (p, test_case, sliding_puzzle_solve_RBFS))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+
+  return ret;
+}
+
+// The portfolio, as a solver reporting the length only if a winner is named.
+static int
+portfolio_solve (Puzzle puzzle)
+{
+  const char *winner = 0;
+  int length = sliding_puzzle_solve_portfolio (puzzle, &winner);
+
+  return winner ? length : -1;
+}
+
+static int
+sliding_puzzle_threads_test ()
+{
+  int grid[] = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };   // 27 moves
+
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  sliding_puzzle_cycle_database_attach (p, 6);
+  sliding_puzzle_threads_set (p, 4);
+  const char *winner = 0;
+  int ret = sliding_puzzle_solve_RBFS (p) == 27 && sliding_puzzle_solve_IDA (p) == 27
+    && sliding_puzzle_solve_portfolio (p, &winner) == 27 && winner ? 0 : -1;
+  sliding_puzzle_release (p);
+
+  // Thresholds and subtrees searched concurrently, and portfolios without cycle detection: odd parity, and non-square
+  // boards.
+  for (int c = 0; !ret && c < NB_TEST_CASES; c++)
+  {
+    const struct sTestCase *test_case = &test_cases[c];
+    p = test_case_init (test_case);
+    sliding_puzzle_threads_set (p, 3);
+    if (test_case_solve (p, test_case, sliding_puzzle_solve_IDA)
+        || test_case_solve (p, test_case, sliding_puzzle_solve_RBFS)
+        || test_case_solve (p, test_case, portfolio_solve))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+
+  return ret;
+}
+
+// Path of a program built next to the test: from the environment variable 'variable' if set, 'program' in the current
+// directory otherwise. Returns 0 (and tells so) if it cannot be run: the tests of the program are then skipped.
+static const char *
+test_program (const char *variable, const char *program)
+{
+  const char *path = getenv (variable);
+  if (!path)
+    path = program;
+  if (access (path, X_OK))
+  {
+    fprintf (stderr, "%s not found, test skipped (set %s to its path).\n", path, variable);
+    return 0;
+  }
+
+  return path;
+}
+
+// The daemon (sp_solve_daemon, see test_program) solves one puzzle sent over its socket.
+static int
+sliding_puzzle_daemon_test ()
+{
+  const char *daemon = test_program ("SP_SOLVE_DAEMON", "./sp_solve_daemon");
+  if (!daemon)
+    return 0;
+
+  int grid[] = { 3, 1, 2, 6, 4, 5, 0, 7, 8 };
+  char path[64];
+  snprintf (path, sizeof (path), "/tmp/sp_solve_test.%ld.sock", (long) getpid ());
+
+  pid_t pid = fork ();
+  if (pid == 0)
+  {
+    execl (daemon, "sp_solve_daemon", "-s", path, "-c", "6", "-p", "4", "3x3", (char *) 0);
+    _exit (127);
+  }
+
+  struct sockaddr_un addr = {.sun_family = AF_UNIX };
+  strcpy (addr.sun_path, path);
+  int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  struct timespec period = {.tv_sec = 0,.tv_nsec = 10000000 };
+  // The socket is bound once the databases are built.
+  for (int i = 0; connect (fd, (struct sockaddr *) &addr, sizeof (addr)); i++)
+    if (i == 1000 || waitpid (pid, 0, WNOHANG))
+    {
+      fprintf (stderr, "Daemon not started.\n");
+      close (fd);
+      kill (pid, SIGTERM);
+      waitpid (pid, 0, 0);
+      return -1;
+    }
+    else
+      nanosleep (&period, 0);
+
+  Puzzle p = sliding_puzzle_init (3, 3, grid, 0);
+  int length = sliding_puzzle_solve_IDA (p);
+  int ret = sliding_puzzle_replay (p, 3, 3, length);
+  sliding_puzzle_release (p);
+
+  struct sSolverRequest request = {.id = 42,.width = 3,.height = 3,.algorithm = SP_DAEMON_IDA };
+  uint8_t tiles[9];
+  for (int i = 0; i < 9; i++)
+    tiles[i] = grid[i];
+  struct sSolverResponse response;
+  uint8_t solution[UINT8_MAX];
+  int moves[UINT8_MAX];
+  if (write (fd, &request, sizeof (request)) != sizeof (request) || write (fd, tiles, sizeof (tiles)) != sizeof (tiles)
+      || recv (fd, &response, sizeof (response), MSG_WAITALL) != sizeof (response)
+      || response.id != 42 || response.status != SP_DAEMON_SOLVED || response.length != length
+      || recv (fd, solution, length, MSG_WAITALL) != length)
+    ret = -1;
+  else
+  {
+    for (int i = 0; i < length; i++)
+      moves[i] = solution[i];
+    if (solution_replay (3, 3, grid, length, moves))
+      ret = -1;
+  }
+  close (fd);
+
+  // The daemon removes its socket on SIGTERM.
+  int status;
+  kill (pid, SIGTERM);
+  waitpid (pid, &status, 0);
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS || !access (path, F_OK))
+    ret = -1;
+
+  return ret;
+}
+
+// The batch solver (sp_solve_batch, see test_program) reads named, numbered (Korf's format) and anonymous lines.
+static int
+sliding_puzzle_batch_test ()
+{
+  const char *batch = test_program ("SP_SOLVE_BATCH", "./sp_solve_batch");
+  if (!batch)
+    return 0;
+
+  struct
+  {
+    const char *line;
+    const char *name;
+    int grid[9];
+  } lines[] = {
+    {"12 3 1 2 6 4 5 0 7 8", "12", {3, 1, 2, 6, 4, 5, 0, 7, 8}},
+    {"even 8 6 7 2 5 4 3 0 1", "even", {8, 6, 7, 2, 5, 4, 3, 0, 1}},
+    {"1 2 3 4 5 6 0 7 8", "3", {1, 2, 3, 4, 5, 6, 0, 7, 8}},   // named after its line number
+  };
+  enum { NB_LINES = sizeof (lines) / sizeof (lines[0]) };
+
+  char filename[64];
+  snprintf (filename, sizeof (filename), "/tmp/sp_solve_test.%ld.txt", (long) getpid ());
+  FILE *f = fopen (filename, "w");
+  if (!f)
+    return -1;
+  for (int i = 0; i < NB_LINES; i++)
+    fprintf (f, "%s\n", lines[i].line);
+  // More numbers than the largest puzzle: reported as not solved rather than truncated.
+  fprintf (f, "long");
+  for (int i = 0; i < 300; i++)
+    fprintf (f, " %i", i);
+  fprintf (f, "\n");
+  fclose (f);
+
+  char command[1024];
+  if (snprintf (command, sizeof (command), "%s -j 2 -c 6 -p 4 %s", batch, filename) >= (int) sizeof (command))
+  {
+    remove (filename);
+    return -1;
+  }
+  FILE *out = popen (command, "r");
+  if (!out)
+  {
+    remove (filename);
+    return -1;
+  }
+  char output[1 << 14];
+  size_t size = fread (output, 1, sizeof (output) - 1, out);
+  output[size] = 0;
+  int ret = pclose (out) ? -1 : 0;
+
+  // Results are written in the order of the input, one line per puzzle: name, length, nodes, time and tiles to move
+  // (debug builds of the library may print traces before them).
+  char *line = output;
+  for (int i = 0; !ret && i < NB_LINES; i++)
+  {
+    char field[16];
+    snprintf (field, sizeof (field), "%s\t", lines[i].name);
+    int length, n;
+    if (!(line = strstr (line, field)) || sscanf (line + strlen (field), "%i %*u %*f%n", &length, &n) != 1)
+    {
+      ret = -1;
+      break;
+    }
+    line += strlen (field) + n;
+    int moves[UINT8_MAX];
+    for (int m = 0; !ret && m < length; m++, line += n)
+      if (sscanf (line, "%i%n", &moves[m], &n) != 1)
+        ret = -1;
+
+    Puzzle p = sliding_puzzle_init (3, 3, lines[i].grid, 0);
+    if (ret || sliding_puzzle_solve_IDA (p) != length || solution_replay (3, 3, lines[i].grid, length, moves))
+      ret = -1;
+    sliding_puzzle_release (p);
+  }
+  if (!ret && !strstr (line, "long\t-1\t"))
+    ret = -1;
+  remove (filename);
+
+  return ret;
+}
+
+// Contention benchmark: 64 threads sharing the databases of one puzzle (sp_solve_test --benchmark).
+static int
+sliding_puzzle_share_benchmark ()
+{
+  enum { NB_THREADS = 64 };
+  struct ShareBenchmark b = { 0, 20000, 0 };
+#if DEBUG
+  b.nbShares = 1000;
+#endif
+
+  b.shared = sliding_puzzle_init (4, 4, 0, 0);
+  sliding_puzzle_cycle_database_attach (b.shared, 2);
+  sliding_puzzle_heuristic_database_attach (b.shared, 2);
+
+  struct timespec t0, t1;
+  clock_gettime (CLOCK_MONOTONIC, &t0);
+
+  pthread_t threads[NB_THREADS];
+  for (int i = 0; i < NB_THREADS; i++)
+    pthread_create (&threads[i], 0, share_benchmark_worker, &b);
+  for (int i = 0; i < NB_THREADS; i++)
+    pthread_join (threads[i], 0);
+
+  clock_gettime (CLOCK_MONOTONIC, &t1);
+  double seconds = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+  printf ("%i threads sharing one database: %.0f shares per second.\n", NB_THREADS,
+          2. * NB_THREADS * b.nbShares / seconds);
+
+  sliding_puzzle_release (b.shared);
+
+  return b.failed ? -1 : 0;
+}
+
+// Bidirectional IDA* against IDA*, with the same heuristic database (sp_solve_test --benchmark).
+static int
+sliding_puzzle_bidirectional_benchmark ()
+{
+  int grids[][16] = {
+    {4, 6, 0, 3, 5, 2, 7, 10, 12, 14, 1, 15, 13, 9, 11, 8},
+    {5, 1, 3, 4, 14, 6, 7, 11, 0, 15, 2, 10, 9, 13, 12, 8},
+    {14, 13, 15, 7, 11, 12, 9, 5, 6, 0, 2, 1, 4, 8, 10, 3},    // Korf #1, 57 moves
+  };
+  int (*solvers[]) (Puzzle) = { sliding_puzzle_solve_IDA, sliding_puzzle_solve_BIDA };
+  const char *names[] = { "IDA*", "bidirectional IDA*" };
+
+  Puzzle shared = sliding_puzzle_init (4, 4, 0, 0);
+  sliding_puzzle_heuristic_database_attach (shared, 2);
+
+  int ret = 0;
+  for (size_t i = 0; !ret && i < sizeof (grids) / sizeof (*grids); i++)
+  {
+    int lengths[2];
+    for (int s = 0; s < 2; s++)
+    {
+      Puzzle puzzle = sliding_puzzle_init (4, 4, grids[i], 0);
+      sliding_puzzle_heuristic_database_share (shared, puzzle);
+      struct timespec t0, t1;
+      clock_gettime (CLOCK_MONOTONIC, &t0);
+      lengths[s] = solvers[s] (puzzle);
+      clock_gettime (CLOCK_MONOTONIC, &t1);
+      struct sPuzzleProgress progress;
+      sliding_puzzle_progress_get (puzzle, &progress);
+      printf ("Puzzle %zu, %s: %i moves, %llu nodes, %.3fs.\n", i + 1, names[s], lengths[s], progress.nodes,
+              (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec));
+      sliding_puzzle_release (puzzle);
+    }
+    if (lengths[0] < 0 || lengths[1] != lengths[0])
+      ret = -1;
+  }
+  sliding_puzzle_release (shared);
+
+  return ret;
+}
+
 int
 sliding_puzzle_TU ()
 {
   // Test
   printf ("%s\n", sliding_puzzle_solver_version ());
 
+  struct
+  {
+    const char *name;
+    int (*test) (void);
+  } tests[] = {
+    {"progress", sliding_puzzle_progress_test},
+    {"publish", sliding_puzzle_publish_test},
+    {"registry", sliding_puzzle_registry_test},
+    {"shared_database", sliding_puzzle_shared_database_test},
+    {"generate", sliding_puzzle_generate_test},
+    {"distance_table", sliding_puzzle_distance_table_test},
+    {"perimeter", sliding_puzzle_perimeter_test},
+    {"table_layout", sliding_puzzle_table_layout_test},
+    {"node_layout", sliding_puzzle_node_layout_test},
+    {"bidirectional", sliding_puzzle_bidirectional_test},
+    {"threads", sliding_puzzle_threads_test},
+    {"daemon", sliding_puzzle_daemon_test},
+    {"batch", sliding_puzzle_batch_test},
+    {"memory_policy", sliding_puzzle_memory_policy_test},
+    {"memory_budget", sliding_puzzle_memory_budget_test},
+    {"pattern_groups", sliding_puzzle_pattern_groups_test},
+  };
+  for (size_t t = 0; t < sizeof (tests) / sizeof (*tests); t++)
+    if (tests[t].test ())
+    {
+      fprintf (stderr, "Test %s failed.\n", tests[t].name);
+      return -1;
+    }
+
   struct UnitTest
   {
     char name[20];
@@ -229,7 +1232,10 @@ sliding_puzzle_TU ()
             preparationTime += 1. * (clock () - t0) / CLOCKS_PER_SEC;
           }
           else if (!sliding_puzzle_cycle_database_share (puzzleOld, puzzle))
+          {
+            fprintf (stderr, "Cycle database of puzzle '%s' not shared.\n", Korf[i].name);
             return -1;
+          }
         }
 
         if (PATTERN_MAX_LENGTH)
@@ -242,7 +1248,10 @@ sliding_puzzle_TU ()
             preparationTime += 1. * (clock () - t0) / CLOCKS_PER_SEC;
           }
           else if (!sliding_puzzle_heuristic_database_share (puzzleOld, puzzle))
+          {
+            fprintf (stderr, "Heuristic database of puzzle '%s' not shared.\n", Korf[i].name);
             return -1;
+          }
         }
 
         if (!puzzleOld)
@@ -257,10 +1266,21 @@ sliding_puzzle_TU ()
         printf ("*****************************************\n");
 
         if (SOLVING_STRATEGY (puzzle) != Korf[i].actual && Korf[i].actual >= 0)
+        {
+          fprintf (stderr, "Puzzle '%s' not solved in %i moves.\n", Korf[i].name, Korf[i].actual);
           return -1;
+        }
 
         printf ("Elapsed CPU time is %.2fs.\n", Korf[i].cpuSeconds[strategy] = 1. * (clock () - t0) / CLOCKS_PER_SEC);
         subTotalTime[strategy] += Korf[i].cpuSeconds[strategy];
+
+        struct sPuzzleProgress progress;
+        if (!sliding_puzzle_progress_get (puzzle, &progress) || progress.running)
+        {
+          fprintf (stderr, "Progress of puzzle '%s' not stopped.\n", Korf[i].name);
+          return -1;
+        }
+        printf ("%llu generated nodes in %i iterations (%.2fs).\n", progress.nodes, progress.iteration, progress.elapsed);
       }
     }
     printf ("Sub-total elapsed CPU time for solving is %.2fs.\n", subTotalTime[strategy]);
@@ -276,6 +1296,21 @@ sliding_puzzle_TU ()
 #endif
   double subTotalTimeRandom = 0;
 
+  // Random puzzles are reproducible from a seed.
+  int grids[2][16];
+  for (int i = 0; i < 2; i++)
+  {
+    sliding_puzzle_random_seed (2018);
+    Puzzle p = sliding_puzzle_init (4, 4, 0, 0);
+    sliding_puzzle_grid_get (p, grids[i]);
+    sliding_puzzle_release (p);
+  }
+  if (memcmp (grids[0], grids[1], sizeof (grids[0])))
+  {
+    fprintf (stderr, "Random puzzles not reproducible from a seed.\n");
+    return -1;
+  }
+
   for (int i = 0; i < nbRandom; i++)
   {
     printf ("*****************************************\n");
@@ -316,12 +1351,16 @@ sliding_puzzle_TU ()
   printf ("Sub-total elapsed CPU time for solving is %.2fs.\n", subTotalTimeRandom);
 
   sliding_puzzle_release (puzzleOld);
+  sliding_puzzle_database_registry_flush ();
 
   return 0;
 }
 
 int
-main (void)
+main (int argc, char *argv[])
 {
-  sliding_puzzle_TU ();
+  if (argc > 1 && !strcmp (argv[1], "--benchmark"))
+    return sliding_puzzle_share_benchmark () || sliding_puzzle_bidirectional_benchmark () ? EXIT_FAILURE : EXIT_SUCCESS;
+
+  return sliding_puzzle_TU () ? EXIT_FAILURE : EXIT_SUCCESS;
 }